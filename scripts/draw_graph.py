@@ -197,8 +197,11 @@ def parse_execution_time(filepath):
     Parse execution time lines from 'filepath', expecting lines like:
       [Aligned] N=1024, threads=2, time=0.679279 sec
       [Blocked] N=1024, threads=8, block_size=64, time=0.125786 sec
+    Runs made with MATMUL_ENERGY=1 also carry RAPL fields:
+      [Blocked] N=1024, threads=8, ..., time=0.125786 sec, joules=9.1, watts=72.3, gflops_per_watt=0.236
     Returns a DataFrame:
-      columns = [Implementation, Size, Threads, Time]
+      columns = [Implementation, Size, Threads, Time, Joules, Watts, GFLOPS_per_Watt]
+      (energy columns are None for runs without RAPL data)
     """
     rows = []
     with open(filepath, 'r') as f:
@@ -221,6 +224,8 @@ def parse_execution_time(filepath):
         size_val = None
         thr_val = 1
         time_val = None
+        energy = {"Joules": None, "Watts": None, "GFLOPS_per_Watt": None}
+        energy_keys = {"joules=": "Joules", "watts=": "Watts", "gflops_per_watt=": "GFLOPS_per_Watt"}
         
         for p in parts:
             # e.g. "N=1024", "threads=2", "time=0.679279 sec"
@@ -240,13 +245,21 @@ def parse_execution_time(filepath):
                     time_val = float(time_str)
                 except ValueError:
                     pass
+            else:
+                for prefix, column in energy_keys.items():
+                    if p.startswith(prefix):
+                        try:
+                            energy[column] = float(p.split('=', 1)[1])
+                        except ValueError:
+                            pass
         
         if (size_val is not None) and (time_val is not None):
             rows.append({
                 "Implementation": impl,
                 "Size": size_val,
                 "Threads": thr_val,
-                "Time": time_val
+                "Time": time_val,
+                **energy
             })
     
     return pd.DataFrame(rows)
@@ -434,6 +447,50 @@ def plot_execution_time_separate(df_time, graph_dir, dpi=300):
             print(f"Saved: {outfile_speedup}")
 
 
+def plot_energy_efficiency_separate(df_time, graph_dir, dpi=300):
+    """
+    For each matrix size with RAPL data (runs made with MATMUL_ENERGY=1),
+    create two PNGs next to the execution time and speedup plots:
+      1) Energy (J) vs. Threads
+      2) GFLOP/s per Watt vs. Threads
+    """
+    if df_time.empty or "Joules" not in df_time.columns:
+        return
+    
+    df_energy = df_time.dropna(subset=["Joules", "GFLOPS_per_Watt"])
+    if df_energy.empty:
+        print("No energy data to plot (run with MATMUL_ENERGY=1 to collect it).")
+        return
+    
+    sns.set_theme(style="whitegrid")
+    unique_sizes = sorted(df_energy["Size"].dropna().unique())
+    
+    for size_val in unique_sizes:
+        subset = df_energy[df_energy["Size"] == size_val]
+        
+        for column, ylabel, title, prefix in [
+            ("Joules", "Energy (J)", "Energy vs. Threads", "energy"),
+            ("GFLOPS_per_Watt", "GFLOP/s per Watt", "Energy Efficiency vs. Threads",
+             "gflops_per_watt"),
+        ]:
+            plt.figure(figsize=(6, 4))
+            sns.lineplot(
+                data=subset, x="Threads", y=column,
+                hue="Implementation", marker="o"
+            )
+            plt.title(f"{title} (N={size_val})")
+            plt.ylabel(ylabel)
+            plt.xlabel("Threads")
+            plt.ylim(0, None)
+            plt.grid(True, linestyle='--', alpha=0.7)
+            plt.legend(loc="best")
+            
+            outfile = os.path.join(graph_dir, f"{prefix}_N{size_val}.png")
+            plt.savefig(outfile, dpi=dpi, bbox_inches="tight")
+            plt.close()
+            print(f"Saved: {outfile}")
+
+
 ##############################################################################
 # Main Entry Point (with parametric directories using argparse)
 ##############################################################################
@@ -538,6 +595,7 @@ def main():
     plot_llc_percentage_separate(df_llc, GRAPH_DIR, dpi=args.dpi)
     plot_cpu_util_separate(df_cpu, GRAPH_DIR, dpi=args.dpi)
     plot_execution_time_separate(df_time, GRAPH_DIR, dpi=args.dpi)
+    plot_energy_efficiency_separate(df_time, GRAPH_DIR, dpi=args.dpi)
 
     print("All plots saved in:", GRAPH_DIR)
 
@@ -20,6 +20,8 @@
 #include <string.h>
 #include <time.h>
 #include <assert.h>
+#include "rapl_energy.h"
+#include "tile_trace.h"
 
 static inline double* aligned_alloc_doubles(size_t N, size_t alignment)
 {
@@ -47,21 +49,32 @@ static inline double get_time_in_seconds()
     return (double)ts.tv_sec + (double)ts.tv_nsec * 1.0e-9;
 }
 
+/* Per-thread tile/row timeline, enabled by MATMUL_TRACE=<file.json>. */
+static tile_trace trace;
+
 void matmul_aligned(double *A, double *B, double *C, int N, int num_threads)
 {
     int i, j, k;
     double sum;
 
-#pragma omp parallel for num_threads(num_threads)        \
+#pragma omp parallel num_threads(num_threads)            \
     shared(A, B, C, N) private(i, j, k, sum)
-    for (i = 0; i < N; i++) {
-        for (j = 0; j < N; j++) {
-            sum = 0.0;
-            for (k = 0; k < N; k++) {
-                sum += A[i*N + k] * B[k*N + j];
+    {
+        int tid = omp_get_thread_num();
+
+#pragma omp for nowait
+        for (i = 0; i < N; i++) {
+            double t_begin = trace_begin(&trace);
+            for (j = 0; j < N; j++) {
+                sum = 0.0;
+                for (k = 0; k < N; k++) {
+                    sum += A[i*N + k] * B[k*N + j];
+                }
+                C[i*N + j] = sum;
             }
-            C[i*N + j] = sum;
+            trace_record(&trace, tid, TRACE_ROWS, t_begin, i, i + 1);
         }
+        trace_barrier(&trace, tid);
     }
 }
 
@@ -84,11 +97,22 @@ int main(int argc, char* argv[])
     fill_random(A, N);
     fill_random(B, N);
 
+    trace_init(&trace, num_threads);
+
+    rapl_meter energy;
+    rapl_start(&energy);
+
     double start = get_time_in_seconds();
     matmul_aligned(A, B, C, N, num_threads);
     double end   = get_time_in_seconds();
+    double joules = rapl_stop(&energy);
+
+    printf("[Aligned] N=%d, threads=%d, time=%f sec", N, num_threads, end - start);
+    rapl_print_fields(joules, end - start, 2.0 * N * N * N);
+    printf("\n");
 
-    printf("[Aligned] N=%d, threads=%d, time=%f sec\n", N, num_threads, end - start);
+    trace_write_chrome(&trace, "matmul_aligned");
+    trace_free(&trace);
 
     free(A);
     free(B);
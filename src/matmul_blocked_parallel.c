@@ -17,6 +17,8 @@
 #include <string.h>
 #include <time.h>
 #include <assert.h>
+#include "rapl_energy.h"
+#include "tile_trace.h"
 
 /* We make BLOCK_SIZE a variable read from the command line. */
 static inline double* aligned_alloc_doubles(size_t N, size_t alignment)
@@ -45,6 +47,9 @@ static inline double get_time_in_seconds()
     return (double)ts.tv_sec + (double)ts.tv_nsec * 1.0e-9;
 }
 
+/* Per-thread tile/row timeline, enabled by MATMUL_TRACE=<file.json>. */
+static tile_trace trace;
+
 /******************************************************************************
  * Cache-blocked multiplication:
  *   Break the matrices into smaller tiles (blocks) to improve cache locality.
@@ -57,24 +62,32 @@ void matmul_blocked(double *A, double *B, double *C,
     int i, j, k;
     double sum;
 
-#pragma omp parallel for num_threads(num_threads) collapse(2) \
+#pragma omp parallel num_threads(num_threads)                 \
     shared(A, B, C, N, block_size)                            \
     private(iBlock, jBlock, kBlock, i, j, k, sum)
-    for (iBlock = 0; iBlock < N; iBlock += block_size) {
-        for (jBlock = 0; jBlock < N; jBlock += block_size) {
-            for (kBlock = 0; kBlock < N; kBlock += block_size) {
-
-                for (i = iBlock; i < iBlock + block_size && i < N; i++) {
-                    for (j = jBlock; j < jBlock + block_size && j < N; j++) {
-                        sum = C[i*N + j];  
-                        for (k = kBlock; k < kBlock + block_size && k < N; k++) {
-                            sum += A[i*N + k] * B[k*N + j];
+    {
+        int tid = omp_get_thread_num();
+
+#pragma omp for collapse(2) nowait
+        for (iBlock = 0; iBlock < N; iBlock += block_size) {
+            for (jBlock = 0; jBlock < N; jBlock += block_size) {
+                double t_begin = trace_begin(&trace);
+                for (kBlock = 0; kBlock < N; kBlock += block_size) {
+
+                    for (i = iBlock; i < iBlock + block_size && i < N; i++) {
+                        for (j = jBlock; j < jBlock + block_size && j < N; j++) {
+                            sum = C[i*N + j];  
+                            for (k = kBlock; k < kBlock + block_size && k < N; k++) {
+                                sum += A[i*N + k] * B[k*N + j];
+                            }
+                            C[i*N + j] = sum;
                         }
-                        C[i*N + j] = sum;
                     }
                 }
+                trace_record(&trace, tid, TRACE_TILE, t_begin, iBlock, jBlock);
             }
         }
+        trace_barrier(&trace, tid);
     }
 }
 
@@ -99,12 +112,23 @@ int main(int argc, char* argv[])
     fill_random(A, N);
     fill_random(B, N);
 
+    trace_init(&trace, num_threads);
+
+    rapl_meter energy;
+    rapl_start(&energy);
+
     double start = get_time_in_seconds();
     matmul_blocked(A, B, C, N, block_size, num_threads);
     double end   = get_time_in_seconds();
+    double joules = rapl_stop(&energy);
 
-    printf("[Blocked] N=%d, threads=%d, block_size=%d, time=%f sec\n",
+    printf("[Blocked] N=%d, threads=%d, block_size=%d, time=%f sec",
            N, num_threads, block_size, end - start);
+    rapl_print_fields(joules, end - start, 2.0 * N * N * N);
+    printf("\n");
+
+    trace_write_chrome(&trace, "matmul_blocked");
+    trace_free(&trace);
 
     free(A);
     free(B);
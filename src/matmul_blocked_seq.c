@@ -3,6 +3,7 @@
 #include <string.h>
 #include <time.h>
 #include <assert.h>
+#include "rapl_energy.h"
 
 /* We make BLOCK_SIZE a variable read from the command line. */
 static inline double* aligned_alloc_doubles(size_t N, size_t alignment)
@@ -81,12 +82,18 @@ int main(int argc, char* argv[])
     fill_random(A, N);
     fill_random(B, N);
 
+    rapl_meter energy;
+    rapl_start(&energy);
+
     double start = get_time_in_seconds();
     matmul_blocked(A, B, C, N, block_size);
     double end   = get_time_in_seconds();
+    double joules = rapl_stop(&energy);
 
-    printf("[Blocked] N=%d, block_size=%d, time=%f sec\n",
+    printf("[Blocked] N=%d, block_size=%d, time=%f sec",
            N, block_size, end - start);
+    rapl_print_fields(joules, end - start, 2.0 * N * N * N);
+    printf("\n");
 
     free(A);
     free(B);
@@ -0,0 +1,506 @@
+/******************************************************************************
+ * File: matmul_complex_parallel.c
+ *
+ * Description:
+ *   Parallel cache-blocked complex matrix multiplication, C = A * B, in
+ *   single (cgemm) and double (zgemm) precision.
+ *
+ *   Both algorithms split A and B into real planes, run real N x N GEMMs
+ *   through the blocked kernel from matmul_blocked_parallel.c, and form C
+ *   in one combine pass:
+ *     4M: T1 = Ar*Br, T2 = Ai*Bi, T3 = Ar*Bi + Ai*Br; Cr = T1 - T2,
+ *         Ci = T3. Four real GEMMs (8 flops per complex multiply-add); the
+ *         most accurate option.
+ *     3M: T1 = Ar*Br, T2 = Ai*Bi, T3 = (Ar+Ai)*(Br+Bi); Cr = T1 - T2,
+ *         Ci = T3 - T1 - T2. Three real GEMMs (6 flops), so about 25% less
+ *         time once the O(N^3) products dominate the O(N^2) split and
+ *         combine passes. The imaginary part is formed by subtraction and so
+ *         can lose relative accuracy when |Ci| is much smaller than |Cr|.
+ *
+ *   Matrices are passed as views { re, im, stride }: element (i, j) is at
+ *   re[(i*N + j)*stride] and im[(i*N + j)*stride]. Interleaved storage
+ *   (re, im, re, im, ...) is { base, base + 1, 2 } and split storage is
+ *   { Re, Im, 1 }; the split pass reads either layout directly.
+ *
+ * Compile:
+ *   gcc -fopenmp matmul_complex_parallel.c -o matmul_complex_parallel -O3 -lm
+ *
+ * Run:
+ *   ./matmul_complex_parallel <matrix_size> <num_threads> <block_size>
+ *                             [4m|3m|all] [double|float] [interleaved|split]
+ *****************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <omp.h>
+#include <string.h>
+#include <time.h>
+#include <math.h>
+#include <float.h>
+#include "rapl_energy.h"
+
+static inline void* aligned_alloc_bytes(size_t bytes, size_t alignment)
+{
+    void *ptr = NULL;
+    int ret = posix_memalign(&ptr, alignment, bytes);
+    if (ret != 0) {
+        fprintf(stderr, "posix_memalign failed\n");
+        exit(EXIT_FAILURE);
+    }
+    memset(ptr, 0, bytes);
+    return ptr;
+}
+
+static inline double get_time_in_seconds()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1.0e-9;
+}
+
+typedef enum { CGEMM_4M, CGEMM_3M } cgemm_algo;
+
+typedef struct { double *re; double *im; int stride; } zmat;
+typedef struct { float  *re; float  *im; int stride; } cmat;
+
+/******************************************************************************
+ * Real blocked kernels
+ *****************************************************************************/
+/* C += A * B; the blocked kernel from matmul_blocked_parallel.c. */
+static void dgemm_blocked(double *A, double *B, double *C, int N, int block_size, int num_threads)
+{
+    int iBlock, jBlock, kBlock;
+    int i, j, k;
+    double sum;
+
+#pragma omp parallel for num_threads(num_threads) collapse(2) \
+    private(iBlock, jBlock, kBlock, i, j, k, sum)
+    for (iBlock = 0; iBlock < N; iBlock += block_size) {
+        for (jBlock = 0; jBlock < N; jBlock += block_size) {
+            for (kBlock = 0; kBlock < N; kBlock += block_size) {
+                for (i = iBlock; i < iBlock + block_size && i < N; i++) {
+                    for (j = jBlock; j < jBlock + block_size && j < N; j++) {
+                        sum = C[i*N + j];
+                        for (k = kBlock; k < kBlock + block_size && k < N; k++) {
+                            sum += A[i*N + k] * B[k*N + j];
+                        }
+                        C[i*N + j] = sum;
+                    }
+                }
+            }
+        }
+    }
+}
+
+/* C += A * B; the blocked kernel from matmul_blocked_parallel.c. */
+static void sgemm_blocked(float *A, float *B, float *C, int N, int block_size, int num_threads)
+{
+    int iBlock, jBlock, kBlock;
+    int i, j, k;
+    float sum;
+
+#pragma omp parallel for num_threads(num_threads) collapse(2) \
+    private(iBlock, jBlock, kBlock, i, j, k, sum)
+    for (iBlock = 0; iBlock < N; iBlock += block_size) {
+        for (jBlock = 0; jBlock < N; jBlock += block_size) {
+            for (kBlock = 0; kBlock < N; kBlock += block_size) {
+                for (i = iBlock; i < iBlock + block_size && i < N; i++) {
+                    for (j = jBlock; j < jBlock + block_size && j < N; j++) {
+                        sum = C[i*N + j];
+                        for (k = kBlock; k < kBlock + block_size && k < N; k++) {
+                            sum += A[i*N + k] * B[k*N + j];
+                        }
+                        C[i*N + j] = sum;
+                    }
+                }
+            }
+        }
+    }
+}
+
+/******************************************************************************
+ * Complex GEMM on real planes
+ *****************************************************************************/
+/* C = A * B in double precision. */
+void zgemm(zmat A, zmat B, zmat C, int N, int block_size, cgemm_algo algo,
+           int num_threads)
+{
+    size_t n = (size_t)N*N;
+    double *work = (double*)aligned_alloc_bytes(9*n * sizeof(double), 64);
+    double *ar = work,       *ai = work + n,   *br = work + 2*n, *bi = work + 3*n;
+    double *as = work + 4*n, *bs = work + 5*n;
+    double *t1 = work + 6*n, *t2 = work + 7*n, *t3 = work + 8*n;
+
+    /* Split into real planes (and the 3M sums). */
+#pragma omp parallel for num_threads(num_threads)
+    for (size_t e = 0; e < n; e++) {
+        ar[e] = A.re[e*A.stride];
+        ai[e] = A.im[e*A.stride];
+        br[e] = B.re[e*B.stride];
+        bi[e] = B.im[e*B.stride];
+        as[e] = ar[e] + ai[e];
+        bs[e] = br[e] + bi[e];
+    }
+
+    dgemm_blocked(ar, br, t1, N, block_size, num_threads);
+    dgemm_blocked(ai, bi, t2, N, block_size, num_threads);
+    if (algo == CGEMM_3M) {
+        dgemm_blocked(as, bs, t3, N, block_size, num_threads);
+    } else {
+        dgemm_blocked(ar, bi, t3, N, block_size, num_threads);
+        dgemm_blocked(ai, br, t3, N, block_size, num_threads);
+    }
+
+#pragma omp parallel for num_threads(num_threads)
+    for (size_t e = 0; e < n; e++) {
+        double a = t1[e], b = t2[e];
+        C.re[e*C.stride] = a - b;
+        C.im[e*C.stride] = algo == CGEMM_3M ? t3[e] - a - b : t3[e];
+    }
+
+    free(work);
+}
+
+/* C = A * B in single precision. */
+void cgemm(cmat A, cmat B, cmat C, int N, int block_size, cgemm_algo algo,
+           int num_threads)
+{
+    size_t n = (size_t)N*N;
+    float *work = (float*)aligned_alloc_bytes(9*n * sizeof(float), 64);
+    float *ar = work,       *ai = work + n,   *br = work + 2*n, *bi = work + 3*n;
+    float *as = work + 4*n, *bs = work + 5*n;
+    float *t1 = work + 6*n, *t2 = work + 7*n, *t3 = work + 8*n;
+
+    /* Split into real planes (and the 3M sums). */
+#pragma omp parallel for num_threads(num_threads)
+    for (size_t e = 0; e < n; e++) {
+        ar[e] = A.re[e*A.stride];
+        ai[e] = A.im[e*A.stride];
+        br[e] = B.re[e*B.stride];
+        bi[e] = B.im[e*B.stride];
+        as[e] = ar[e] + ai[e];
+        bs[e] = br[e] + bi[e];
+    }
+
+    sgemm_blocked(ar, br, t1, N, block_size, num_threads);
+    sgemm_blocked(ai, bi, t2, N, block_size, num_threads);
+    if (algo == CGEMM_3M) {
+        sgemm_blocked(as, bs, t3, N, block_size, num_threads);
+    } else {
+        sgemm_blocked(ar, bi, t3, N, block_size, num_threads);
+        sgemm_blocked(ai, br, t3, N, block_size, num_threads);
+    }
+
+#pragma omp parallel for num_threads(num_threads)
+    for (size_t e = 0; e < n; e++) {
+        float a = t1[e], b = t2[e];
+        C.re[e*C.stride] = a - b;
+        C.im[e*C.stride] = algo == CGEMM_3M ? t3[e] - a - b : t3[e];
+    }
+
+    free(work);
+}
+
+/******************************************************************************
+ * Benchmark driver: double precision
+ *****************************************************************************/
+static zmat zmat_alloc(int N, int interleaved, double **storage)
+{
+    size_t n = (size_t)N*N;
+    zmat m;
+    *storage = (double*)aligned_alloc_bytes(2*n * sizeof(double), 64);
+    if (interleaved) {
+        m.re = *storage; m.im = *storage + 1; m.stride = 2;
+    } else {
+        m.re = *storage; m.im = *storage + n; m.stride = 1;
+    }
+    return m;
+}
+
+static void zmat_fill_random(zmat m, int N)
+{
+    for (size_t e = 0; e < (size_t)N*N; e++) {
+        m.re[e*m.stride] = (double)(2.0 * rand() / RAND_MAX - 1.0);
+        m.im[e*m.stride] = (double)(2.0 * rand() / RAND_MAX - 1.0);
+    }
+}
+
+/* max |X - Y| / max |Y| over both parts. */
+static double zmat_rel_diff(zmat X, zmat Y, int N)
+{
+    double num = 0.0, den = 0.0;
+    for (size_t e = 0; e < (size_t)N*N; e++) {
+        double dr = fabs((double)X.re[e*X.stride] - (double)Y.re[e*Y.stride]);
+        double di = fabs((double)X.im[e*X.stride] - (double)Y.im[e*Y.stride]);
+        double yr = fabs((double)Y.re[e*Y.stride]);
+        double yi = fabs((double)Y.im[e*Y.stride]);
+        if (dr > num) num = dr;
+        if (di > num) num = di;
+        if (yr > den) den = yr;
+        if (yi > den) den = yi;
+    }
+    return den > 0.0 ? num / den : num;
+}
+
+/* Compares C with a long double reference. Returns the number of elements
+ * whose error exceeds 4*(N+2)*eps*M_ij, M_ij = sum_k (|ar|+|ai|)(|br|+|bi|),
+ * a forward-error bound loose enough for both 4M and 3M; *rel_diff gets
+ * max |C - ref| / max |ref|. */
+static long zmat_check(zmat C, zmat A, zmat B, int N, int num_threads,
+                        double *rel_diff)
+{
+    double num = 0.0, den = 0.0;
+    long bad = 0;
+
+#pragma omp parallel for num_threads(num_threads) reduction(max:num, den) reduction(+:bad)
+    for (int i = 0; i < N; i++) {
+        for (int j = 0; j < N; j++) {
+            long double rr = 0.0L, ri = 0.0L, mag = 0.0L;
+            for (int k = 0; k < N; k++) {
+                size_t a = (size_t)i*N + k, b = (size_t)k*N + j;
+                long double ar = A.re[a*A.stride], ai = A.im[a*A.stride];
+                long double br = B.re[b*B.stride], bi = B.im[b*B.stride];
+                rr  += ar * br - ai * bi;
+                ri  += ar * bi + ai * br;
+                mag += (fabsl(ar) + fabsl(ai)) * (fabsl(br) + fabsl(bi));
+            }
+            size_t c = (size_t)i*N + j;
+            double dr = fabs((double)(C.re[c*C.stride] - rr));
+            double di = fabs((double)(C.im[c*C.stride] - ri));
+            double bound = 4.0 * (N + 2) * DBL_EPSILON * (double)mag;
+            if (dr > num) num = dr;
+            if (di > num) num = di;
+            if (fabs((double)rr) > den) den = fabs((double)rr);
+            if (fabs((double)ri) > den) den = fabs((double)ri);
+            bad += (dr > bound) + (di > bound);
+        }
+    }
+    *rel_diff = den > 0.0 ? num / den : num;
+    return bad;
+}
+
+static long zbench(int N, int num_threads, int block_size, int run_4m, int run_3m,
+                    int interleaved)
+{
+    double *sa, *sb, *s4, *s3;
+    zmat A  = zmat_alloc(N, interleaved, &sa);
+    zmat B  = zmat_alloc(N, interleaved, &sb);
+    zmat C4 = zmat_alloc(N, interleaved, &s4);
+    zmat C3 = zmat_alloc(N, interleaved, &s3);
+    double n3 = (double)N * N * N;
+    const char *layout = interleaved ? "interleaved" : "split";
+    rapl_meter energy;
+    double rel_diff;
+    long bad = 0;
+
+    zmat_fill_random(A, N);
+    zmat_fill_random(B, N);
+
+    if (run_4m) {
+        rapl_start(&energy);
+        double start = get_time_in_seconds();
+        zgemm(A, B, C4, N, block_size, CGEMM_4M, num_threads);
+        double t = get_time_in_seconds() - start;
+        double joules = rapl_stop(&energy);
+        bad += zmat_check(C4, A, B, N, num_threads, &rel_diff);
+        printf("[ZGEMM-4M] N=%d, threads=%d, block_size=%d, layout=%s, "
+               "time=%f sec, GFLOP/s=%.3f, rel_diff_vs_ref=%.3e", N,
+               num_threads, block_size, layout, t, 8.0 * n3 / t * 1.0e-9, rel_diff);
+        rapl_print_fields(joules, t, 8.0 * n3);
+        printf("\n");
+    }
+    if (run_3m) {
+        rapl_start(&energy);
+        double start = get_time_in_seconds();
+        zgemm(A, B, C3, N, block_size, CGEMM_3M, num_threads);
+        double t = get_time_in_seconds() - start;
+        double joules = rapl_stop(&energy);
+        bad += zmat_check(C3, A, B, N, num_threads, &rel_diff);
+        printf("[ZGEMM-3M] N=%d, threads=%d, block_size=%d, layout=%s, "
+               "time=%f sec, GFLOP/s=%.3f, effective_GFLOP/s=%.3f, "
+               "rel_diff_vs_ref=%.3e",
+               N, num_threads, block_size, layout, t,
+               6.0 * n3 / t * 1.0e-9, 8.0 * n3 / t * 1.0e-9, rel_diff);
+        if (run_4m) {
+            printf(", rel_diff_vs_4M=%.3e", zmat_rel_diff(C3, C4, N));
+        }
+        rapl_print_fields(joules, t, 6.0 * n3);
+        printf("\n");
+    }
+
+    free(sa); free(sb); free(s4); free(s3);
+    return bad;
+}
+
+/******************************************************************************
+ * Benchmark driver: single precision
+ *****************************************************************************/
+static cmat cmat_alloc(int N, int interleaved, float **storage)
+{
+    size_t n = (size_t)N*N;
+    cmat m;
+    *storage = (float*)aligned_alloc_bytes(2*n * sizeof(float), 64);
+    if (interleaved) {
+        m.re = *storage; m.im = *storage + 1; m.stride = 2;
+    } else {
+        m.re = *storage; m.im = *storage + n; m.stride = 1;
+    }
+    return m;
+}
+
+static void cmat_fill_random(cmat m, int N)
+{
+    for (size_t e = 0; e < (size_t)N*N; e++) {
+        m.re[e*m.stride] = (float)(2.0 * rand() / RAND_MAX - 1.0);
+        m.im[e*m.stride] = (float)(2.0 * rand() / RAND_MAX - 1.0);
+    }
+}
+
+/* max |X - Y| / max |Y| over both parts. */
+static double cmat_rel_diff(cmat X, cmat Y, int N)
+{
+    double num = 0.0, den = 0.0;
+    for (size_t e = 0; e < (size_t)N*N; e++) {
+        double dr = fabs((double)X.re[e*X.stride] - (double)Y.re[e*Y.stride]);
+        double di = fabs((double)X.im[e*X.stride] - (double)Y.im[e*Y.stride]);
+        double yr = fabs((double)Y.re[e*Y.stride]);
+        double yi = fabs((double)Y.im[e*Y.stride]);
+        if (dr > num) num = dr;
+        if (di > num) num = di;
+        if (yr > den) den = yr;
+        if (yi > den) den = yi;
+    }
+    return den > 0.0 ? num / den : num;
+}
+
+/* Compares C with a long double reference. Returns the number of elements
+ * whose error exceeds 4*(N+2)*eps*M_ij, M_ij = sum_k (|ar|+|ai|)(|br|+|bi|),
+ * a forward-error bound loose enough for both 4M and 3M; *rel_diff gets
+ * max |C - ref| / max |ref|. */
+static long cmat_check(cmat C, cmat A, cmat B, int N, int num_threads,
+                        double *rel_diff)
+{
+    double num = 0.0, den = 0.0;
+    long bad = 0;
+
+#pragma omp parallel for num_threads(num_threads) reduction(max:num, den) reduction(+:bad)
+    for (int i = 0; i < N; i++) {
+        for (int j = 0; j < N; j++) {
+            long double rr = 0.0L, ri = 0.0L, mag = 0.0L;
+            for (int k = 0; k < N; k++) {
+                size_t a = (size_t)i*N + k, b = (size_t)k*N + j;
+                long double ar = A.re[a*A.stride], ai = A.im[a*A.stride];
+                long double br = B.re[b*B.stride], bi = B.im[b*B.stride];
+                rr  += ar * br - ai * bi;
+                ri  += ar * bi + ai * br;
+                mag += (fabsl(ar) + fabsl(ai)) * (fabsl(br) + fabsl(bi));
+            }
+            size_t c = (size_t)i*N + j;
+            double dr = fabs((double)(C.re[c*C.stride] - rr));
+            double di = fabs((double)(C.im[c*C.stride] - ri));
+            double bound = 4.0 * (N + 2) * FLT_EPSILON * (double)mag;
+            if (dr > num) num = dr;
+            if (di > num) num = di;
+            if (fabs((double)rr) > den) den = fabs((double)rr);
+            if (fabs((double)ri) > den) den = fabs((double)ri);
+            bad += (dr > bound) + (di > bound);
+        }
+    }
+    *rel_diff = den > 0.0 ? num / den : num;
+    return bad;
+}
+
+static long cbench(int N, int num_threads, int block_size, int run_4m, int run_3m,
+                    int interleaved)
+{
+    float *sa, *sb, *s4, *s3;
+    cmat A  = cmat_alloc(N, interleaved, &sa);
+    cmat B  = cmat_alloc(N, interleaved, &sb);
+    cmat C4 = cmat_alloc(N, interleaved, &s4);
+    cmat C3 = cmat_alloc(N, interleaved, &s3);
+    double n3 = (double)N * N * N;
+    const char *layout = interleaved ? "interleaved" : "split";
+    rapl_meter energy;
+    double rel_diff;
+    long bad = 0;
+
+    cmat_fill_random(A, N);
+    cmat_fill_random(B, N);
+
+    if (run_4m) {
+        rapl_start(&energy);
+        double start = get_time_in_seconds();
+        cgemm(A, B, C4, N, block_size, CGEMM_4M, num_threads);
+        double t = get_time_in_seconds() - start;
+        double joules = rapl_stop(&energy);
+        bad += cmat_check(C4, A, B, N, num_threads, &rel_diff);
+        printf("[CGEMM-4M] N=%d, threads=%d, block_size=%d, layout=%s, "
+               "time=%f sec, GFLOP/s=%.3f, rel_diff_vs_ref=%.3e", N,
+               num_threads, block_size, layout, t, 8.0 * n3 / t * 1.0e-9, rel_diff);
+        rapl_print_fields(joules, t, 8.0 * n3);
+        printf("\n");
+    }
+    if (run_3m) {
+        rapl_start(&energy);
+        double start = get_time_in_seconds();
+        cgemm(A, B, C3, N, block_size, CGEMM_3M, num_threads);
+        double t = get_time_in_seconds() - start;
+        double joules = rapl_stop(&energy);
+        bad += cmat_check(C3, A, B, N, num_threads, &rel_diff);
+        printf("[CGEMM-3M] N=%d, threads=%d, block_size=%d, layout=%s, "
+               "time=%f sec, GFLOP/s=%.3f, effective_GFLOP/s=%.3f, "
+               "rel_diff_vs_ref=%.3e",
+               N, num_threads, block_size, layout, t,
+               6.0 * n3 / t * 1.0e-9, 8.0 * n3 / t * 1.0e-9, rel_diff);
+        if (run_4m) {
+            printf(", rel_diff_vs_4M=%.3e", cmat_rel_diff(C3, C4, N));
+        }
+        rapl_print_fields(joules, t, 6.0 * n3);
+        printf("\n");
+    }
+
+    free(sa); free(sb); free(s4); free(s3);
+    return bad;
+}
+
+int main(int argc, char* argv[])
+{
+    if (argc < 4) {
+        fprintf(stderr, "Usage: %s <matrix_size> <num_threads> <block_size> "
+                        "[4m|3m|all] [double|float] [interleaved|split]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    int N             = atoi(argv[1]);
+    int num_threads   = atoi(argv[2]);
+    int block_size    = atoi(argv[3]);
+    const char *algo  = (argc > 4) ? argv[4] : "all";
+    const char *prec  = (argc > 5) ? argv[5] : "double";
+    const char *store = (argc > 6) ? argv[6] : "interleaved";
+    int run_4m        = !strcmp(algo, "4m") || !strcmp(algo, "all");
+    int run_3m        = !strcmp(algo, "3m") || !strcmp(algo, "all");
+    int interleaved   = !strcmp(store, "interleaved");
+
+    if ((!run_4m && !run_3m) ||
+        (strcmp(prec, "double") && strcmp(prec, "float")) ||
+        (!interleaved && strcmp(store, "split"))) {
+        fprintf(stderr, "Unknown mode '%s %s %s'\n", algo, prec, store);
+        return EXIT_FAILURE;
+    }
+
+    srand((unsigned)time(NULL));
+
+    long bad;
+    if (!strcmp(prec, "double")) {
+        bad = zbench(N, num_threads, block_size, run_4m, run_3m, interleaved);
+    } else {
+        bad = cbench(N, num_threads, block_size, run_4m, run_3m, interleaved);
+    }
+
+    if (bad > 0) {
+        fprintf(stderr, "%ld elements differ from the reference beyond the "
+                        "error bound\n", bad);
+        return EXIT_FAILURE;
+    }
+    return 0;
+}
@@ -0,0 +1,464 @@
+/******************************************************************************
+ * File: matmul_expr.hpp
+ *
+ * Description:
+ *   Lazy matrix expressions for the blocked/parallel GEMM kernel.
+ *
+ *     matexpr::Matrix A(n, n), B(n, n), C(n, n), E(n, n), F(n, n), D(n, n);
+ *     D = A*B + C*E - 0.5*F;
+ *
+ *   Operators only build a small expression tree (expression templates); no
+ *   arithmetic happens until the tree is assigned to a Matrix. Assignment
+ *   then lowers the tree to a flat list of terms
+ *
+ *     D = beta*D + sum_g alpha_g * A_g*B_g + sum_e c_e * X_e
+ *
+ *   and evaluates all of them in ONE parallel pass over the tiles of D: each
+ *   tile is initialised from beta*D and the elementwise terms X_e (fused
+ *   write-back, no separate elementwise sweeps), then every product is
+ *   accumulated into it while it is still in cache. Scalars are folded into
+ *   alpha, D appearing on the right-hand side as a plain term becomes beta,
+ *   and repeated terms are merged. The only temporaries are operands of a
+ *   product that are themselves expressions, e.g. (A+B)*C or A*B*C.
+ *
+ *   If D is an operand of a product (D = D*B + C) the result is computed
+ *   into a temporary and moved into D, since the product reads D while the
+ *   pass writes it.
+ *
+ *   matexpr::config() holds the thread count and tile size used by the
+ *   evaluator; matexpr::last_eval() reports how the last assignment was
+ *   lowered (GEMM terms, elementwise terms, temporaries, passes).
+ *****************************************************************************/
+
+#ifndef MATMUL_EXPR_HPP
+#define MATMUL_EXPR_HPP
+
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <new>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include <omp.h>
+
+namespace matexpr {
+
+struct EvalConfig {
+    int num_threads = 1;
+    int block_size  = 64;
+};
+
+struct EvalStats {
+    int gemm_terms        = 0;  /* A*B products accumulated */
+    int elementwise_terms = 0;  /* X terms fused into the write-back */
+    int temporaries       = 0;  /* full matrices allocated during evaluation */
+    int passes            = 0;  /* parallel passes (over D or a temporary) */
+};
+
+inline EvalConfig& config()
+{
+    static EvalConfig cfg;
+    return cfg;
+}
+
+inline EvalStats& last_eval()
+{
+    static EvalStats stats;
+    return stats;
+}
+
+template <typename E>
+struct Expr {
+    const E& self() const { return static_cast<const E&>(*this); }
+};
+
+class Matrix;
+template <typename E> struct is_matrix : std::is_same<E, Matrix> {};
+
+/* Leaves are held by reference, inner nodes by value (they are temporaries). */
+template <typename E>
+using node_t = std::conditional_t<is_matrix<E>::value, const Matrix&, E>;
+
+class TermList;
+
+/******************************************************************************
+ * Matrix: row-major, 64-byte aligned storage
+ *****************************************************************************/
+class Matrix : public Expr<Matrix> {
+public:
+    Matrix() = default;
+
+    Matrix(int rows, int cols) : rows_(rows), cols_(cols)
+    {
+        if (rows < 0 || cols < 0) throw std::invalid_argument("negative matrix dimension");
+        size_t n = (size_t)rows * cols;
+        void *ptr = NULL;
+        if (posix_memalign(&ptr, 64, (n ? n : 1) * sizeof(double)) != 0) throw std::bad_alloc();
+        data_ = (double*)ptr;
+        memset(data_, 0, n * sizeof(double));
+    }
+
+    Matrix(const Matrix &other) : Matrix(other.rows_, other.cols_)
+    {
+        memcpy(data_, other.data_, other.size() * sizeof(double));
+    }
+
+    Matrix(Matrix &&other) noexcept
+        : rows_(other.rows_), cols_(other.cols_), data_(other.data_)
+    {
+        other.rows_ = other.cols_ = 0;
+        other.data_ = NULL;
+    }
+
+    template <typename E>
+    Matrix(const Expr<E> &expr);
+
+    ~Matrix() { free(data_); }
+
+    Matrix& operator=(const Matrix &other)
+    {
+        if (this != &other) {
+            Matrix copy(other);
+            swap(copy);
+        }
+        return *this;
+    }
+
+    Matrix& operator=(Matrix &&other) noexcept
+    {
+        swap(other);
+        return *this;
+    }
+
+    template <typename E> Matrix& operator=(const Expr<E> &expr);
+    template <typename E> Matrix& operator+=(const Expr<E> &expr);
+    template <typename E> Matrix& operator-=(const Expr<E> &expr);
+
+    void swap(Matrix &other) noexcept
+    {
+        std::swap(rows_, other.rows_);
+        std::swap(cols_, other.cols_);
+        std::swap(data_, other.data_);
+    }
+
+    int rows() const { return rows_; }
+    int cols() const { return cols_; }
+    size_t size() const { return (size_t)rows_ * cols_; }
+    double* data() { return data_; }
+    const double* data() const { return data_; }
+    double& operator()(int i, int j) { return data_[(size_t)i*cols_ + j]; }
+    double operator()(int i, int j) const { return data_[(size_t)i*cols_ + j]; }
+
+    /* Expression protocol */
+    int expr_rows() const { return rows_; }
+    int expr_cols() const { return cols_; }
+    void collect(double alpha, TermList &terms) const;
+
+private:
+    template <typename E> void assign(const Expr<E> &expr, double self_coef);
+
+    int     rows_ = 0;
+    int     cols_ = 0;
+    double *data_ = NULL;
+};
+
+/******************************************************************************
+ * Lowered form: beta*D + sum alpha*A*B + sum c*X
+ *****************************************************************************/
+struct GemmTerm {
+    double        alpha;
+    const Matrix *A;
+    const Matrix *B;
+};
+
+struct AxpyTerm {
+    double        coef;
+    const Matrix *X;
+};
+
+class TermList {
+public:
+    std::vector<GemmTerm> gemms;
+    std::vector<AxpyTerm> axpys;
+    std::deque<Matrix>    temps;   /* deque: references stay valid on growth */
+    EvalStats             nested;  /* work done evaluating the temporaries */
+
+    void add_axpy(double coef, const Matrix &X)
+    {
+        for (AxpyTerm &t : axpys) {
+            if (t.X == &X) {
+                t.coef += coef;
+                return;
+            }
+        }
+        axpys.push_back({ coef, &X });
+    }
+
+    void add_gemm(double alpha, const Matrix &A, const Matrix &B)
+    {
+        for (GemmTerm &t : gemms) {
+            if (t.A == &A && t.B == &B) {
+                t.alpha += alpha;
+                return;
+            }
+        }
+        gemms.push_back({ alpha, &A, &B });
+    }
+
+    /* A product operand as a Matrix: leaves as-is, scalars pulled into alpha,
+       anything else evaluated into a temporary. */
+    template <typename E>
+    const Matrix& materialize(const E &e, double &alpha);
+};
+
+/******************************************************************************
+ * Expression nodes
+ *****************************************************************************/
+template <typename E>
+struct ScaledExpr : Expr<ScaledExpr<E>> {
+    double    scale;
+    node_t<E> expr;
+
+    ScaledExpr(double s, const E &e) : scale(s), expr(e) {}
+    int expr_rows() const { return expr.expr_rows(); }
+    int expr_cols() const { return expr.expr_cols(); }
+    void collect(double alpha, TermList &terms) const { expr.collect(alpha * scale, terms); }
+};
+
+template <typename L, typename R>
+struct SumExpr : Expr<SumExpr<L, R>> {
+    node_t<L> lhs;
+    node_t<R> rhs;
+
+    SumExpr(const L &l, const R &r) : lhs(l), rhs(r)
+    {
+        if (l.expr_rows() != r.expr_rows() || l.expr_cols() != r.expr_cols()) {
+            throw std::invalid_argument("matrix sum: shape mismatch");
+        }
+    }
+    int expr_rows() const { return lhs.expr_rows(); }
+    int expr_cols() const { return lhs.expr_cols(); }
+    void collect(double alpha, TermList &terms) const
+    {
+        lhs.collect(alpha, terms);
+        rhs.collect(alpha, terms);
+    }
+};
+
+template <typename L, typename R>
+struct ProductExpr : Expr<ProductExpr<L, R>> {
+    node_t<L> lhs;
+    node_t<R> rhs;
+
+    ProductExpr(const L &l, const R &r) : lhs(l), rhs(r)
+    {
+        if (l.expr_cols() != r.expr_rows()) {
+            throw std::invalid_argument("matrix product: inner dimensions differ");
+        }
+    }
+    int expr_rows() const { return lhs.expr_rows(); }
+    int expr_cols() const { return rhs.expr_cols(); }
+    void collect(double alpha, TermList &terms) const
+    {
+        const Matrix &a = terms.materialize(lhs, alpha);
+        const Matrix &b = terms.materialize(rhs, alpha);
+        terms.add_gemm(alpha, a, b);
+    }
+};
+
+template <typename E> struct is_scaled : std::false_type {};
+template <typename E> struct is_scaled<ScaledExpr<E>> : std::true_type {};
+
+template <typename E>
+const Matrix& TermList::materialize(const E &e, double &alpha)
+{
+    if constexpr (is_matrix<E>::value) {
+        return e;
+    } else if constexpr (is_scaled<E>::value) {
+        alpha *= e.scale;
+        return materialize(e.expr, alpha);
+    } else {
+        temps.emplace_back(e);
+        nested.gemm_terms        += last_eval().gemm_terms;
+        nested.elementwise_terms += last_eval().elementwise_terms;
+        nested.temporaries       += last_eval().temporaries;
+        nested.passes            += last_eval().passes;
+        return temps.back();
+    }
+}
+
+inline void Matrix::collect(double alpha, TermList &terms) const
+{
+    terms.add_axpy(alpha, *this);
+}
+
+template <typename E>
+using enable_expr = std::enable_if_t<std::is_base_of<Expr<E>, E>::value, int>;
+
+template <typename L, typename R, enable_expr<L> = 0, enable_expr<R> = 0>
+SumExpr<L, R> operator+(const L &l, const R &r) { return SumExpr<L, R>(l, r); }
+
+template <typename L, typename R, enable_expr<L> = 0, enable_expr<R> = 0>
+SumExpr<L, ScaledExpr<R>> operator-(const L &l, const R &r)
+{
+    return SumExpr<L, ScaledExpr<R>>(l, ScaledExpr<R>(-1.0, r));
+}
+
+template <typename L, typename R, enable_expr<L> = 0, enable_expr<R> = 0>
+ProductExpr<L, R> operator*(const L &l, const R &r) { return ProductExpr<L, R>(l, r); }
+
+template <typename E, enable_expr<E> = 0>
+ScaledExpr<E> operator*(double s, const E &e) { return ScaledExpr<E>(s, e); }
+
+template <typename E, enable_expr<E> = 0>
+ScaledExpr<E> operator*(const E &e, double s) { return ScaledExpr<E>(s, e); }
+
+template <typename E, enable_expr<E> = 0>
+ScaledExpr<E> operator-(const E &e) { return ScaledExpr<E>(-1.0, e); }
+
+/******************************************************************************
+ * Fused evaluator: one pass over the tiles of D.
+ *   D_tile = beta*D_tile + sum c*X_tile       (elementwise, fused write-back)
+ *   D_tile += alpha*A_panel*B_panel  for every GEMM term (ikj, SIMD over j)
+ *****************************************************************************/
+inline void evaluate_terms(double *D, int M, int N, double beta,
+                           const std::vector<GemmTerm> &gemms,
+                           const std::vector<AxpyTerm> &axpys)
+{
+    const int bs          = config().block_size > 0 ? config().block_size : 64;
+    const int num_threads = config().num_threads > 0 ? config().num_threads : 1;
+    const int nx          = (int)axpys.size();
+
+#pragma omp parallel for num_threads(num_threads) collapse(2) schedule(static)
+    for (int iBlock = 0; iBlock < M; iBlock += bs) {
+        for (int jBlock = 0; jBlock < N; jBlock += bs) {
+            const int iEnd = iBlock + bs < M ? iBlock + bs : M;
+            const int jEnd = jBlock + bs < N ? jBlock + bs : N;
+
+            if (!(beta == 1.0 && nx == 0)) {
+                for (int i = iBlock; i < iEnd; i++) {
+                    double *d = D + (size_t)i*N;
+#pragma omp simd
+                    for (int j = jBlock; j < jEnd; j++) {
+                        d[j] = (beta == 0.0) ? 0.0 : beta * d[j];
+                    }
+                    for (int t = 0; t < nx; t++) {
+                        const double  c = axpys[t].coef;
+                        const double *x = axpys[t].X->data() + (size_t)i*N;
+#pragma omp simd
+                        for (int j = jBlock; j < jEnd; j++) {
+                            d[j] += c * x[j];
+                        }
+                    }
+                }
+            }
+
+            for (const GemmTerm &g : gemms) {
+                const int     K = g.A->cols();
+                const double *A = g.A->data();
+                const double *B = g.B->data();
+
+                for (int kBlock = 0; kBlock < K; kBlock += bs) {
+                    const int kEnd = kBlock + bs < K ? kBlock + bs : K;
+                    for (int i = iBlock; i < iEnd; i++) {
+                        double *d = D + (size_t)i*N;
+                        for (int k = kBlock; k < kEnd; k++) {
+                            const double  a = g.alpha * A[(size_t)i*K + k];
+                            const double *b = B + (size_t)k*N;
+#pragma omp simd
+                            for (int j = jBlock; j < jEnd; j++) {
+                                d[j] += a * b[j];
+                            }
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
+
+/* D = self_coef*D + expr */
+template <typename E>
+void Matrix::assign(const Expr<E> &expr, double self_coef)
+{
+    const E &e = expr.self();
+    const int rows = e.expr_rows();
+    const int cols = e.expr_cols();
+    const bool resize = rows != rows_ || cols != cols_;
+    TermList terms;
+    double beta = self_coef;
+    bool aliased = false;
+
+    if (resize && self_coef != 0.0) {
+        throw std::invalid_argument("compound assignment: shape mismatch");
+    }
+
+    e.collect(1.0, terms);
+
+    /* D as a plain term becomes beta; D inside a product forces a temporary. */
+    for (size_t t = 0; t < terms.axpys.size(); t++) {
+        if (terms.axpys[t].X == this) {
+            beta += terms.axpys[t].coef;
+            terms.axpys.erase(terms.axpys.begin() + t--);
+        }
+    }
+    /* Terms that cancelled out (A*B - A*B) cost nothing. */
+    for (size_t t = 0; t < terms.axpys.size(); t++) {
+        if (terms.axpys[t].coef == 0.0) terms.axpys.erase(terms.axpys.begin() + t--);
+    }
+    for (size_t t = 0; t < terms.gemms.size(); t++) {
+        if (terms.gemms[t].alpha == 0.0) terms.gemms.erase(terms.gemms.begin() + t--);
+    }
+    for (const GemmTerm &g : terms.gemms) {
+        aliased = aliased || g.A == this || g.B == this;
+    }
+
+    EvalStats stats         = terms.nested;
+    stats.gemm_terms       += (int)terms.gemms.size();
+    stats.elementwise_terms += (int)terms.axpys.size();
+    stats.temporaries      += (int)terms.temps.size() + (aliased ? 1 : 0);
+    stats.passes           += 1;
+
+    if (aliased || resize) {
+        Matrix result(rows, cols);
+        if (beta != 0.0) terms.axpys.push_back({ beta, this });
+        evaluate_terms(result.data_, rows, cols, 0.0, terms.gemms, terms.axpys);
+        swap(result);
+    } else {
+        evaluate_terms(data_, rows, cols, beta, terms.gemms, terms.axpys);
+    }
+    last_eval() = stats;
+}
+
+template <typename E>
+Matrix::Matrix(const Expr<E> &expr)
+{
+    assign(expr, 0.0);
+}
+
+template <typename E>
+Matrix& Matrix::operator=(const Expr<E> &expr)
+{
+    assign(expr, 0.0);
+    return *this;
+}
+
+template <typename E>
+Matrix& Matrix::operator+=(const Expr<E> &expr)
+{
+    assign(expr, 1.0);
+    return *this;
+}
+
+template <typename E>
+Matrix& Matrix::operator-=(const Expr<E> &expr)
+{
+    assign(ScaledExpr<E>(-1.0, expr.self()), 1.0);
+    return *this;
+}
+
+} /* namespace matexpr */
+
+#endif /* MATMUL_EXPR_HPP */
@@ -0,0 +1,171 @@
+/******************************************************************************
+ * File: matmul_expr_parallel.cpp
+ *
+ * Description:
+ *   Benchmark for the lazy expression templates in matmul_expr.hpp.
+ *   Evaluates
+ *
+ *     D = A*B + C*E - 0.5*F
+ *
+ *   twice: eagerly, the way the separate matmul_* programs would (one
+ *   matmul_blocked() call per product into its own N x N temporary, then
+ *   one elementwise pass per + and -), and lazily, where the assignment is
+ *   lowered to two GEMM terms accumulated into D in a single pass with the
+ *   -0.5*F term fused into the tile write-back. Prints both times, the
+ *   number of temporaries and passes, and the largest difference between
+ *   the two results.
+ *
+ * Compile:
+ *   g++ -fopenmp -std=c++17 matmul_expr_parallel.cpp -o matmul_expr_parallel -O3
+ *
+ * Run:
+ *   ./matmul_expr_parallel <matrix_size> <num_threads> <block_size>
+ *****************************************************************************/
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cmath>
+#include <cfloat>
+#include <ctime>
+#include <omp.h>
+#include "matmul_expr.hpp"
+
+static inline double* aligned_alloc_doubles(size_t N, size_t alignment)
+{
+    void *ptr = NULL;
+    int ret = posix_memalign(&ptr, alignment, N * sizeof(double));
+    if (ret != 0) {
+        fprintf(stderr, "posix_memalign failed\n");
+        exit(EXIT_FAILURE);
+    }
+    memset(ptr, 0, N * sizeof(double));
+    return (double*)ptr;
+}
+
+static inline void fill_random(double *mat, int N)
+{
+    for (int i = 0; i < N*N; i++) {
+        mat[i] = (double)rand() / (double)RAND_MAX;
+    }
+}
+
+static inline double get_time_in_seconds()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1.0e-9;
+}
+
+/******************************************************************************
+ * Eager baseline: identical to matmul_blocked() in matmul_blocked_parallel.c
+ *****************************************************************************/
+void matmul_blocked(double *A, double *B, double *C,
+                    int N, int block_size, int num_threads)
+{
+    int iBlock, jBlock, kBlock;
+    int i, j, k;
+    double sum;
+
+#pragma omp parallel for num_threads(num_threads) collapse(2) \
+    shared(A, B, C, N, block_size)                            \
+    private(iBlock, jBlock, kBlock, i, j, k, sum)
+    for (iBlock = 0; iBlock < N; iBlock += block_size) {
+        for (jBlock = 0; jBlock < N; jBlock += block_size) {
+            for (kBlock = 0; kBlock < N; kBlock += block_size) {
+
+                for (i = iBlock; i < iBlock + block_size && i < N; i++) {
+                    for (j = jBlock; j < jBlock + block_size && j < N; j++) {
+                        sum = C[i*N + j];
+                        for (k = kBlock; k < kBlock + block_size && k < N; k++) {
+                            sum += A[i*N + k] * B[k*N + j];
+                        }
+                        C[i*N + j] = sum;
+                    }
+                }
+            }
+        }
+    }
+}
+
+/* Z = X + s*Y, one elementwise pass */
+static void axpy_pass(const double *X, double s, const double *Y, double *Z,
+                      size_t n, int num_threads)
+{
+#pragma omp parallel for num_threads(num_threads) schedule(static)
+    for (size_t i = 0; i < n; i++) {
+        Z[i] = X[i] + s * Y[i];
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    if (argc < 4) {
+        fprintf(stderr, "Usage: %s <matrix_size> <num_threads> <block_size>\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    int N           = atoi(argv[1]);
+    int num_threads = atoi(argv[2]);
+    int block_size  = atoi(argv[3]);
+    size_t n        = (size_t)N * N;
+
+    matexpr::config().num_threads = num_threads;
+    matexpr::config().block_size  = block_size;
+
+    matexpr::Matrix A(N, N), B(N, N), C(N, N), E(N, N), F(N, N), D(N, N);
+
+    srand((unsigned)time(NULL));
+
+    fill_random(A.data(), N);
+    fill_random(B.data(), N);
+    fill_random(C.data(), N);
+    fill_random(E.data(), N);
+    fill_random(F.data(), N);
+
+    /* Eager: T1 = A*B, T2 = C*E, T3 = T1 + T2, D_eager = T3 - 0.5*F */
+    double *T1      = aligned_alloc_doubles(n, 64);
+    double *T2      = aligned_alloc_doubles(n, 64);
+    double *T3      = aligned_alloc_doubles(n, 64);
+    double *D_eager = aligned_alloc_doubles(n, 64);
+
+    double start = get_time_in_seconds();
+    matmul_blocked(A.data(), B.data(), T1, N, block_size, num_threads);
+    matmul_blocked(C.data(), E.data(), T2, N, block_size, num_threads);
+    axpy_pass(T1, 1.0, T2, T3, n, num_threads);
+    axpy_pass(T3, -0.5, F.data(), D_eager, n, num_threads);
+    double end = get_time_in_seconds();
+    double eager_time = end - start;
+
+    /* Lazy: one fused pass into D */
+    start = get_time_in_seconds();
+    D = A*B + C*E - 0.5*F;
+    end = get_time_in_seconds();
+    double lazy_time = end - start;
+    const matexpr::EvalStats &stats = matexpr::last_eval();
+
+    double max_diff = 0.0;
+    for (size_t i = 0; i < n; i++) {
+        double d = fabs(D.data()[i] - D_eager[i]);
+        if (d > max_diff) max_diff = d;
+    }
+
+    printf("[Expr] N=%d, threads=%d, block_size=%d, gemm_terms=%d, fused_terms=%d, "
+           "temporaries=%d (eager 3), passes=%d (eager 4), eager_time=%f sec, "
+           "time=%f sec, max_diff=%e\n",
+           N, num_threads, block_size, stats.gemm_terms, stats.elementwise_terms,
+           stats.temporaries, stats.passes, eager_time, lazy_time, max_diff);
+
+    free(T1);
+    free(T2);
+    free(T3);
+    free(D_eager);
+
+    /* Entries of A*B + C*E are at most 2N (inputs in [0, 1]); allow N*eps
+     * relative to that for the different summation order. */
+    if (max_diff > 2.0 * N * N * DBL_EPSILON) {
+        fprintf(stderr, "Fused result differs from the eager one beyond 2*N^2*eps\n");
+        return EXIT_FAILURE;
+    }
+    return 0;
+}
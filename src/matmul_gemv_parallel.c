@@ -0,0 +1,398 @@
+/******************************************************************************
+ * File: matmul_gemv_parallel.c
+ *
+ * Description:
+ *   Bandwidth-oriented parallel matrix-vector kernels:
+ *
+ *     gemv:    y = alpha * A   * x + beta * y
+ *     gemv_t:  y = alpha * A^T * x + beta * y
+ *     batched: Y = alpha * A   * X + beta * Y for num_vectors vectors at once,
+ *              so each pass over A serves up to MAX_VECTORS (32) vectors.
+ *
+ *   GEMV does 2 flops per 8-byte element of A, so it is bound by memory
+ *   bandwidth, not compute. The kernels stream A exactly once:
+ *     - gemv works on 4 rows at a time (4 independent SIMD accumulators that
+ *       share each x load) and prefetches ahead in all 4 row streams.
+ *     - gemv_t gives each thread a contiguous slice of y and walks down the
+ *       rows, 4 at a time, so every access is unit-stride and no reduction
+ *       between threads is needed.
+ *     - batched keeps X and Y interleaved (X[k*num_vectors + v]) so the
+ *       inner loop over vectors is contiguous.
+ *   The driver reports achieved GB/s rather than GFLOP/s.
+ *
+ * Compile:
+ *   gcc -fopenmp matmul_gemv_parallel.c -o matmul_gemv_parallel -O3 -lm
+ *
+ * Run:
+ *   ./matmul_gemv_parallel <matrix_size> <num_threads>
+ *                          [gemv|gemv_t|batched|all] [num_vectors] [reps]
+ *****************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <omp.h>
+#include <string.h>
+#include <time.h>
+#include <math.h>
+#include <float.h>
+#include "rapl_energy.h"
+
+#define GEMV_ROWS       4     /* rows per SIMD accumulator group */
+#define PREFETCH_CHUNK  64    /* doubles per k chunk (8 cache lines) */
+#define PREFETCH_DIST   256   /* doubles ahead in each row stream */
+#define MAX_VECTORS     32    /* vectors per accumulator chunk in batched */
+
+static inline double* aligned_alloc_doubles(size_t N, size_t alignment)
+{
+    void *ptr = NULL;
+    int ret = posix_memalign(&ptr, alignment, N * sizeof(double));
+    if (ret != 0) {
+        fprintf(stderr, "posix_memalign failed\n");
+        exit(EXIT_FAILURE);
+    }
+    memset(ptr, 0, N * sizeof(double));
+    return (double*)ptr;
+}
+
+static inline void fill_random_n(double *v, size_t n)
+{
+    for (size_t i = 0; i < n; i++) {
+        v[i] = (double)rand() / (double)RAND_MAX;
+    }
+}
+
+static inline double get_time_in_seconds()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1.0e-9;
+}
+
+static inline double scale_y(double beta, double y)
+{
+    return (beta == 0.0) ? 0.0 : beta * y;
+}
+
+/******************************************************************************
+ * y = alpha * A * x + beta * y
+ *****************************************************************************/
+void gemv(double alpha, const double *A, const double *x, double beta, double *y,
+          int N, int num_threads)
+{
+    int groups = N / GEMV_ROWS;
+
+#pragma omp parallel num_threads(num_threads)
+    {
+#pragma omp for schedule(static) nowait
+        for (int g = 0; g < groups; g++) {
+            const double *a0 = A + (size_t)(g * GEMV_ROWS) * N;
+            const double *a1 = a0 + N;
+            const double *a2 = a1 + N;
+            const double *a3 = a2 + N;
+            double s0 = 0.0, s1 = 0.0, s2 = 0.0, s3 = 0.0;
+
+            for (int kc = 0; kc < N; kc += PREFETCH_CHUNK) {
+                int kEnd = kc + PREFETCH_CHUNK < N ? kc + PREFETCH_CHUNK : N;
+                if (kc + PREFETCH_DIST < N) {
+                    for (int p = 0; p < PREFETCH_CHUNK; p += 8) {
+                        __builtin_prefetch(a0 + kc + PREFETCH_DIST + p, 0, 0);
+                        __builtin_prefetch(a1 + kc + PREFETCH_DIST + p, 0, 0);
+                        __builtin_prefetch(a2 + kc + PREFETCH_DIST + p, 0, 0);
+                        __builtin_prefetch(a3 + kc + PREFETCH_DIST + p, 0, 0);
+                    }
+                }
+#pragma omp simd reduction(+:s0, s1, s2, s3)
+                for (int k = kc; k < kEnd; k++) {
+                    double xk = x[k];
+                    s0 += a0[k] * xk;
+                    s1 += a1[k] * xk;
+                    s2 += a2[k] * xk;
+                    s3 += a3[k] * xk;
+                }
+            }
+
+            int i = g * GEMV_ROWS;
+            y[i]     = alpha * s0 + scale_y(beta, y[i]);
+            y[i + 1] = alpha * s1 + scale_y(beta, y[i + 1]);
+            y[i + 2] = alpha * s2 + scale_y(beta, y[i + 2]);
+            y[i + 3] = alpha * s3 + scale_y(beta, y[i + 3]);
+        }
+
+        /* Leftover rows when N is not a multiple of GEMV_ROWS. */
+#pragma omp for schedule(static)
+        for (int i = groups * GEMV_ROWS; i < N; i++) {
+            const double *a = A + (size_t)i * N;
+            double s = 0.0;
+#pragma omp simd reduction(+:s)
+            for (int k = 0; k < N; k++) {
+                s += a[k] * x[k];
+            }
+            y[i] = alpha * s + scale_y(beta, y[i]);
+        }
+    }
+}
+
+/******************************************************************************
+ * y = alpha * A^T * x + beta * y
+ *****************************************************************************/
+void gemv_t(double alpha, const double *A, const double *x, double beta, double *y,
+            int N, int num_threads)
+{
+#pragma omp parallel num_threads(num_threads)
+    {
+        int nt  = omp_get_num_threads();
+        int tid = omp_get_thread_num();
+        /* Column slice of y owned by this thread, rounded to cache lines. */
+        int per = ((N + nt - 1) / nt + 7) & ~7;
+        int j0  = tid * per < N ? tid * per : N;
+        int j1  = j0 + per < N ? j0 + per : N;
+        double *yj = y + j0;
+        int len = j1 - j0;
+        int i = 0;
+
+        for (int j = 0; j < len; j++) {
+            yj[j] = scale_y(beta, yj[j]);
+        }
+
+        for (; i + GEMV_ROWS <= N; i += GEMV_ROWS) {
+            const double *a0 = A + (size_t)i * N + j0;
+            const double *a1 = a0 + N;
+            const double *a2 = a1 + N;
+            const double *a3 = a2 + N;
+            double x0 = alpha * x[i],     x1 = alpha * x[i + 1];
+            double x2 = alpha * x[i + 2], x3 = alpha * x[i + 3];
+
+            if (i + GEMV_ROWS < N) {
+                for (int p = 0; p < len; p += 8) {
+                    __builtin_prefetch(a3 + N + p, 0, 0);
+                }
+            }
+#pragma omp simd
+            for (int j = 0; j < len; j++) {
+                yj[j] += x0 * a0[j] + x1 * a1[j] + x2 * a2[j] + x3 * a3[j];
+            }
+        }
+        for (; i < N; i++) {
+            const double *a = A + (size_t)i * N + j0;
+            double xi = alpha * x[i];
+#pragma omp simd
+            for (int j = 0; j < len; j++) {
+                yj[j] += xi * a[j];
+            }
+        }
+    }
+}
+
+/******************************************************************************
+ * Y = alpha * A * X + beta * Y, X and Y interleaved: X[k*nv + v], Y[i*nv + v]
+ * Vectors are processed MAX_VECTORS at a time so the accumulators stay in a
+ * fixed-size register/stack block; each row of A is read once per chunk.
+ *****************************************************************************/
+void gemv_batched(double alpha, const double *A, const double *X, double beta,
+                  double *Y, int N, int num_vectors, int num_threads)
+{
+#pragma omp parallel for num_threads(num_threads) schedule(static)
+    for (int i = 0; i < N; i++) {
+        const double *a = A + (size_t)i * N;
+        double *yi = Y + (size_t)i * num_vectors;
+
+        for (int v0 = 0; v0 < num_vectors; v0 += MAX_VECTORS) {
+            const int nv = num_vectors - v0 < MAX_VECTORS ? num_vectors - v0 : MAX_VECTORS;
+            double acc[MAX_VECTORS] = { 0.0 };
+
+            for (int k = 0; k < N; k++) {
+                double aik = a[k];
+                const double *xk = X + (size_t)k * num_vectors + v0;
+                if ((k & 7) == 0 && k + PREFETCH_DIST < N) {
+                    __builtin_prefetch(a + k + PREFETCH_DIST, 0, 0);
+                }
+#pragma omp simd
+                for (int v = 0; v < nv; v++) {
+                    acc[v] += aik * xk[v];
+                }
+            }
+
+            for (int v = 0; v < nv; v++) {
+                yi[v0 + v] = alpha * acc[v] + scale_y(beta, yi[v0 + v]);
+            }
+        }
+    }
+}
+
+/******************************************************************************
+ * Benchmark driver
+ *****************************************************************************/
+
+/* Plain reference for ref = 2 * op(A) * X + 0.5 * Y0, X/Y0 interleaved by nv. */
+static void reference_gemv(const double *A, const double *X, const double *Y0,
+                           double *ref, int N, int nv, int trans)
+{
+    for (int i = 0; i < N; i++) {
+        for (int v = 0; v < nv; v++) {
+            double sum = 0.0;
+            for (int k = 0; k < N; k++) {
+                double a = trans ? A[(size_t)k*N + i] : A[(size_t)i*N + k];
+                sum += a * X[(size_t)k*nv + v];
+            }
+            ref[(size_t)i*nv + v] = 2.0 * sum + 0.5 * Y0[(size_t)i*nv + v];
+        }
+    }
+}
+
+static double max_rel_diff(const double *X, const double *Y, size_t n)
+{
+    double max_diff = 0.0, max_ref = 0.0;
+    for (size_t i = 0; i < n; i++) {
+        double d = fabs(X[i] - Y[i]);
+        if (d > max_diff) max_diff = d;
+        if (fabs(Y[i]) > max_ref) max_ref = fabs(Y[i]);
+    }
+    return max_ref > 0.0 ? max_diff / max_ref : max_diff;
+}
+
+/* seconds is the best rep; energy is per call, averaged over all reps. */
+static void report(const char *name, int N, int num_threads, int num_vectors,
+                   double bytes, double flops, double seconds, double rel_diff,
+                   double joules, double total_seconds, int reps)
+{
+    printf("[%s] N=%d, threads=%d, vectors=%d, time=%f sec, GB/s=%.3f, GFLOP/s=%.3f, "
+           "max_rel_diff=%e",
+           name, N, num_threads, num_vectors, seconds,
+           bytes / seconds * 1.0e-9, flops / seconds * 1.0e-9, rel_diff);
+    rapl_print_fields(joules < 0.0 ? joules : joules / reps, total_seconds / reps, flops);
+    printf("\n");
+}
+
+int main(int argc, char* argv[])
+{
+    if (argc < 3) {
+        fprintf(stderr, "Usage: %s <matrix_size> <num_threads> "
+                        "[gemv|gemv_t|batched|all] [num_vectors] [reps]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    int N            = atoi(argv[1]);
+    int num_threads  = atoi(argv[2]);
+    const char *mode = (argc > 3) ? argv[3] : "all";
+    int num_vectors  = (argc > 4) ? atoi(argv[4]) : 8;
+    int reps         = (argc > 5) ? atoi(argv[5]) : 10;
+    int run_gemv     = !strcmp(mode, "gemv")    || !strcmp(mode, "all");
+    int run_gemv_t   = !strcmp(mode, "gemv_t")  || !strcmp(mode, "all");
+    int run_batched  = !strcmp(mode, "batched") || !strcmp(mode, "all");
+
+    if (!run_gemv && !run_gemv_t && !run_batched) {
+        fprintf(stderr, "Unknown mode '%s'\n", mode);
+        return EXIT_FAILURE;
+    }
+    if (num_vectors < 1 || reps < 1) {
+        fprintf(stderr, "num_vectors and reps must be >= 1\n");
+        return EXIT_FAILURE;
+    }
+
+    double *A = aligned_alloc_doubles((size_t)N*N, 64);
+    double *x = aligned_alloc_doubles((size_t)N, 64);
+    double *y = aligned_alloc_doubles((size_t)N, 64);
+    double *X = aligned_alloc_doubles((size_t)N*num_vectors, 64);
+    double *Y = aligned_alloc_doubles((size_t)N*num_vectors, 64);
+    double *Y0  = aligned_alloc_doubles((size_t)N*num_vectors, 64);
+    double *ref = aligned_alloc_doubles((size_t)N*num_vectors, 64);
+    double nn = (double)N * (double)N;
+    double tol = N * DBL_EPSILON;
+    int failures = 0;
+    rapl_meter energy;
+
+    srand((unsigned)time(NULL));
+
+    /* First-touch A in parallel so pages land on the threads that stream them. */
+#pragma omp parallel for num_threads(num_threads) schedule(static)
+    for (int i = 0; i < N; i++) {
+        for (int k = 0; k < N; k++) {
+            A[(size_t)i*N + k] = (double)((i * 31 + k * 17) % 1000) * 1.0e-3;
+        }
+    }
+    fill_random_n(x, (size_t)N);
+    fill_random_n(X, (size_t)N*num_vectors);
+    fill_random_n(Y0, (size_t)N*num_vectors);
+
+    /* Each kernel is timed, then checked once with alpha = 2, beta = 0.5
+     * against reference_gemv(); all inputs are non-negative, so N*eps bounds
+     * the relative error of any summation order. */
+
+    /* Best of reps; beta = 1 so y is read and written every time. */
+    if (run_gemv) {
+        double best = 1e30, total = 0.0;
+        rapl_start(&energy);
+        for (int r = 0; r < reps; r++) {
+            double start = get_time_in_seconds();
+            gemv(1.0, A, x, 1.0, y, N, num_threads);
+            double t = get_time_in_seconds() - start;
+            if (t < best) best = t;
+            total += t;
+        }
+        double joules = rapl_stop(&energy);
+        memcpy(y, Y0, (size_t)N * sizeof(double));
+        gemv(2.0, A, x, 0.5, y, N, num_threads);
+        reference_gemv(A, x, Y0, ref, N, 1, 0);
+        double rel_diff = max_rel_diff(y, ref, (size_t)N);
+        failures += rel_diff > tol;
+        report("GEMV", N, num_threads, 1, 8.0 * (nn + 3.0 * N), 2.0 * nn, best, rel_diff,
+               joules, total, reps);
+    }
+
+    if (run_gemv_t) {
+        double best = 1e30, total = 0.0;
+        rapl_start(&energy);
+        for (int r = 0; r < reps; r++) {
+            double start = get_time_in_seconds();
+            gemv_t(1.0, A, x, 1.0, y, N, num_threads);
+            double t = get_time_in_seconds() - start;
+            if (t < best) best = t;
+            total += t;
+        }
+        double joules = rapl_stop(&energy);
+        memcpy(y, Y0, (size_t)N * sizeof(double));
+        gemv_t(2.0, A, x, 0.5, y, N, num_threads);
+        reference_gemv(A, x, Y0, ref, N, 1, 1);
+        double rel_diff = max_rel_diff(y, ref, (size_t)N);
+        failures += rel_diff > tol;
+        report("GEMV_T", N, num_threads, 1, 8.0 * (nn + 3.0 * N), 2.0 * nn, best, rel_diff,
+               joules, total, reps);
+    }
+
+    if (run_batched) {
+        /* A is streamed once per MAX_VECTORS chunk of vectors. */
+        double chunks = (double)((num_vectors + MAX_VECTORS - 1) / MAX_VECTORS);
+        double best = 1e30, total = 0.0;
+        rapl_start(&energy);
+        for (int r = 0; r < reps; r++) {
+            double start = get_time_in_seconds();
+            gemv_batched(1.0, A, X, 1.0, Y, N, num_vectors, num_threads);
+            double t = get_time_in_seconds() - start;
+            if (t < best) best = t;
+            total += t;
+        }
+        double joules = rapl_stop(&energy);
+        memcpy(Y, Y0, (size_t)N*num_vectors * sizeof(double));
+        gemv_batched(2.0, A, X, 0.5, Y, N, num_vectors, num_threads);
+        reference_gemv(A, X, Y0, ref, N, num_vectors, 0);
+        double rel_diff = max_rel_diff(Y, ref, (size_t)N*num_vectors);
+        failures += rel_diff > tol;
+        report("GEMV_BATCHED", N, num_threads, num_vectors,
+               8.0 * (nn * chunks + 3.0 * (double)N * num_vectors),
+               2.0 * nn * num_vectors, best, rel_diff, joules, total, reps);
+    }
+
+    free(A);
+    free(x);
+    free(y);
+    free(X);
+    free(Y);
+    free(Y0);
+    free(ref);
+
+    if (failures > 0) {
+        fprintf(stderr, "Result differs from the reference beyond N*eps\n");
+        return EXIT_FAILURE;
+    }
+    return 0;
+}
@@ -0,0 +1,444 @@
+/******************************************************************************
+ * File: matmul_hybrid_parallel.c
+ *
+ * Description:
+ *   Parallel cache-blocked matrix multiplication for hybrid CPUs that mix
+ *   performance (P) and efficiency (E) cores. With a static schedule every
+ *   thread gets the same number of C tiles, so the P-cores finish early and
+ *   wait at the barrier for the E-cores. This version:
+ *
+ *     1. Detects the core type each thread runs on, from
+ *        /sys/devices/cpu_core/cpus and /sys/devices/cpu_atom/cpus, or from
+ *        CPUID leaf 0x1A when sysfs does not expose the hybrid PMUs.
+ *     2. Calibrates per-thread throughput with a short tile workload run on
+ *        all threads at once.
+ *     3. Hands out C tiles statically (baseline), proportionally to the
+ *        calibrated throughput, or dynamically one tile at a time.
+ *     4. Reports each thread's share of the work and its barrier wait.
+ *
+ *   Proportional mode assumes threads stay on their cores, so run it with
+ *   OMP_PROC_BIND=true (and optionally OMP_PLACES=cores).
+ *
+ * Compile:
+ *   gcc -fopenmp matmul_hybrid_parallel.c -o matmul_hybrid_parallel -O3 -lm
+ *
+ * Run:
+ *   ./matmul_hybrid_parallel <matrix_size> <num_threads> <block_size>
+ *                            [static|proportional|dynamic]
+ *****************************************************************************/
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <omp.h>
+#include <string.h>
+#include <time.h>
+#include <sched.h>
+#include <math.h>
+#include <float.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+#endif
+#include "rapl_energy.h"
+
+#define MAX_CPUS        1024
+#define CALIB_TILE      64
+#define CALIB_REPS      8
+
+static inline double* aligned_alloc_doubles(size_t N, size_t alignment)
+{
+    void *ptr = NULL;
+    int ret = posix_memalign(&ptr, alignment, N * sizeof(double));
+    if (ret != 0) {
+        fprintf(stderr, "posix_memalign failed\n");
+        exit(EXIT_FAILURE);
+    }
+    memset(ptr, 0, N * sizeof(double));
+    return (double*)ptr;
+}
+
+static inline void fill_random(double *mat, int N)
+{
+    for (int i = 0; i < N*N; i++) {
+        mat[i] = (double)rand() / (double)RAND_MAX;
+    }
+}
+
+static inline double get_time_in_seconds()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1.0e-9;
+}
+
+/******************************************************************************
+ * Core type detection
+ *****************************************************************************/
+typedef enum { CORE_UNKNOWN = 0, CORE_P, CORE_E } core_type;
+
+static const char* core_type_name(core_type t)
+{
+    switch (t) {
+    case CORE_P: return "P";
+    case CORE_E: return "E";
+    default:     return "?";
+    }
+}
+
+/* Mark every CPU of a sysfs cpulist ("0-7,16,18-19") with the given type. */
+static int read_cpulist(const char *path, core_type type, core_type *map)
+{
+    FILE *f = fopen(path, "r");
+    char buf[4096];
+    int found = 0;
+
+    if (f == NULL) return 0;
+    if (fgets(buf, sizeof(buf), f) != NULL) {
+        char *tok = strtok(buf, ",\n");
+        while (tok != NULL) {
+            int lo, hi;
+            int n = sscanf(tok, "%d-%d", &lo, &hi);
+            if (n == 1) hi = lo;
+            if (n >= 1) {
+                for (int c = lo; c <= hi && c < MAX_CPUS; c++) {
+                    map[c] = type;
+                    found++;
+                }
+            }
+            tok = strtok(NULL, ",\n");
+        }
+    }
+    fclose(f);
+    return found;
+}
+
+/* Returns 1 if sysfs describes a hybrid part, filling map[] per logical CPU. */
+static int detect_core_types_sysfs(core_type *map)
+{
+    int p = read_cpulist("/sys/devices/cpu_core/cpus", CORE_P, map);
+    int e = read_cpulist("/sys/devices/cpu_atom/cpus", CORE_E, map);
+    return p > 0 && e > 0;
+}
+
+/* CPUID leaf 0x1A reports the type of the core the caller is running on. */
+static core_type detect_core_type_cpuid(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+    unsigned eax, ebx, ecx, edx;
+
+    if (__get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx) && (edx & (1u << 15))) {
+        if (__get_cpuid_count(0x1A, 0, &eax, &ebx, &ecx, &edx)) {
+            switch (eax >> 24) {
+            case 0x40: return CORE_P;
+            case 0x20: return CORE_E;
+            default:   break;
+            }
+        }
+    }
+#endif
+    return CORE_UNKNOWN;
+}
+
+/******************************************************************************
+ * Per-thread bookkeeping, padded to a cache line to avoid false sharing.
+ *****************************************************************************/
+typedef struct {
+    int       cpu;
+    core_type type;
+    double    weight;       /* calibrated GFLOP/s */
+    long      tiles;        /* C tiles computed */
+    double    busy;         /* seconds spent computing tiles */
+    double    finish;       /* time the thread ran out of work */
+    char      pad[24];
+} thread_stats;
+
+_Static_assert(sizeof(thread_stats) % 64 == 0, "thread_stats must fill whole cache lines");
+
+/* One full tile row-block of C: C[iBlock.., jBlock..] += A * B over all k. */
+static inline void compute_tile(const double *A, const double *B, double *C,
+                                int N, int block_size, int iBlock, int jBlock)
+{
+    int iEnd = iBlock + block_size < N ? iBlock + block_size : N;
+    int jEnd = jBlock + block_size < N ? jBlock + block_size : N;
+
+    for (int kBlock = 0; kBlock < N; kBlock += block_size) {
+        int kEnd = kBlock + block_size < N ? kBlock + block_size : N;
+        for (int i = iBlock; i < iEnd; i++) {
+            for (int j = jBlock; j < jEnd; j++) {
+                double sum = C[i*N + j];
+                for (int k = kBlock; k < kEnd; k++) {
+                    sum += A[i*N + k] * B[k*N + j];
+                }
+                C[i*N + j] = sum;
+            }
+        }
+    }
+}
+
+/*
+ * Short calibration: every thread multiplies a private tile a few times at
+ * the same time as the others, so shared-cache and turbo effects under full
+ * load are included in the measured throughput.
+ */
+static void calibrate(thread_stats *stats, int num_threads, int sysfs_hybrid,
+                      const core_type *map)
+{
+#pragma omp parallel num_threads(num_threads)
+    {
+        int tid = omp_get_thread_num();
+        int T   = CALIB_TILE;
+        double *a = aligned_alloc_doubles((size_t)T*T, 64);
+        double *b = aligned_alloc_doubles((size_t)T*T, 64);
+        double *c = aligned_alloc_doubles((size_t)T*T, 64);
+
+        for (int i = 0; i < T*T; i++) {
+            a[i] = 1.0 + (double)i / (T*T);
+            b[i] = 1.0 - (double)i / (T*T);
+        }
+
+        stats[tid].cpu  = sched_getcpu();
+        stats[tid].type = (sysfs_hybrid && stats[tid].cpu >= 0 && stats[tid].cpu < MAX_CPUS)
+                          ? map[stats[tid].cpu] : detect_core_type_cpuid();
+
+        /* Warm up caches and clocks once before timing. */
+        compute_tile(a, b, c, T, T, 0, 0);
+#pragma omp barrier
+        double start = get_time_in_seconds();
+        for (int r = 0; r < CALIB_REPS; r++) {
+            compute_tile(a, b, c, T, T, 0, 0);
+        }
+        double elapsed = get_time_in_seconds() - start;
+
+        stats[tid].weight = 2.0 * T * T * T * CALIB_REPS / elapsed * 1.0e-9;
+
+        free(a);
+        free(b);
+        free(c);
+    }
+}
+
+/******************************************************************************
+ * Work distribution modes
+ *****************************************************************************/
+typedef enum { DIST_STATIC, DIST_PROPORTIONAL, DIST_DYNAMIC } dist_mode;
+
+static const char* dist_mode_name(dist_mode m)
+{
+    switch (m) {
+    case DIST_STATIC:       return "static";
+    case DIST_PROPORTIONAL: return "proportional";
+    default:                return "dynamic";
+    }
+}
+
+void matmul_hybrid(double *A, double *B, double *C, int N, int block_size,
+                   int num_threads, dist_mode mode, thread_stats *stats)
+{
+    int nb          = (N + block_size - 1) / block_size;
+    long num_tiles  = (long)nb * nb;
+    long *first     = (long*)calloc((size_t)num_threads + 1, sizeof(long));
+
+    if (first == NULL) {
+        fprintf(stderr, "calloc failed\n");
+        exit(EXIT_FAILURE);
+    }
+
+#pragma omp parallel num_threads(num_threads)
+    {
+        int tid = omp_get_thread_num();
+        long tiles = 0;
+        double busy_start;
+
+        /* Proportional split: thread t owns tiles [first[t], first[t+1]).
+         * Computed from the team we actually got, which can be smaller than
+         * num_threads under nesting, OMP_THREAD_LIMIT or dynamic teams. */
+        if (mode == DIST_PROPORTIONAL) {
+#pragma omp single
+            {
+                int team = omp_get_num_threads();
+                double total_w = 0.0, acc = 0.0;
+                for (int t = 0; t < team; t++) {
+                    total_w += stats[t].weight;
+                }
+                for (int t = 0; t < team; t++) {
+                    first[t] = total_w > 0.0
+                        ? (long)(acc / total_w * (double)num_tiles + 0.5)
+                        : (long)t * num_tiles / team;
+                    acc += stats[t].weight;
+                }
+                first[team] = num_tiles;
+            }
+        }
+        busy_start = get_time_in_seconds();
+
+        if (mode == DIST_STATIC) {
+#pragma omp for schedule(static) nowait
+            for (long t = 0; t < num_tiles; t++) {
+                compute_tile(A, B, C, N, block_size,
+                             (int)(t / nb) * block_size, (int)(t % nb) * block_size);
+                tiles++;
+            }
+        } else if (mode == DIST_DYNAMIC) {
+#pragma omp for schedule(dynamic, 1) nowait
+            for (long t = 0; t < num_tiles; t++) {
+                compute_tile(A, B, C, N, block_size,
+                             (int)(t / nb) * block_size, (int)(t % nb) * block_size);
+                tiles++;
+            }
+        } else {
+            for (long t = first[tid]; t < first[tid + 1]; t++) {
+                compute_tile(A, B, C, N, block_size,
+                             (int)(t / nb) * block_size, (int)(t % nb) * block_size);
+                tiles++;
+            }
+        }
+
+        stats[tid].finish = get_time_in_seconds();
+        stats[tid].busy   = stats[tid].finish - busy_start;
+        stats[tid].tiles  = tiles;
+    }
+
+    free(first);
+}
+
+/******************************************************************************
+ * Reference: the blocked GEMM from matmul_blocked_parallel.c
+ *****************************************************************************/
+void matmul_blocked(double *A, double *B, double *C,
+                    int N, int block_size, int num_threads)
+{
+    int iBlock, jBlock, kBlock;
+    int i, j, k;
+    double sum;
+
+#pragma omp parallel for num_threads(num_threads) collapse(2) \
+    shared(A, B, C, N, block_size)                            \
+    private(iBlock, jBlock, kBlock, i, j, k, sum)
+    for (iBlock = 0; iBlock < N; iBlock += block_size) {
+        for (jBlock = 0; jBlock < N; jBlock += block_size) {
+            for (kBlock = 0; kBlock < N; kBlock += block_size) {
+
+                for (i = iBlock; i < iBlock + block_size && i < N; i++) {
+                    for (j = jBlock; j < jBlock + block_size && j < N; j++) {
+                        sum = C[i*N + j];
+                        for (k = kBlock; k < kBlock + block_size && k < N; k++) {
+                            sum += A[i*N + k] * B[k*N + j];
+                        }
+                        C[i*N + j] = sum;
+                    }
+                }
+            }
+        }
+    }
+}
+
+static double max_rel_diff(const double *X, const double *Y, size_t n)
+{
+    double max_diff = 0.0, max_ref = 0.0;
+    for (size_t i = 0; i < n; i++) {
+        double d = fabs(X[i] - Y[i]);
+        if (d > max_diff) max_diff = d;
+        if (fabs(Y[i]) > max_ref) max_ref = fabs(Y[i]);
+    }
+    return max_ref > 0.0 ? max_diff / max_ref : max_diff;
+}
+
+static void print_report(const thread_stats *stats, int num_threads, double end)
+{
+    long total_tiles = 0;
+    for (int t = 0; t < num_threads; t++) {
+        total_tiles += stats[t].tiles;
+    }
+
+    printf("  thread  cpu  type  calib_GFLOP/s  tiles   share   busy_s    wait_s\n");
+    for (int t = 0; t < num_threads; t++) {
+        printf("  %6d  %3d  %4s  %13.3f  %5ld  %5.1f%%  %7.4f  %8.4f\n",
+               t, stats[t].cpu, core_type_name(stats[t].type), stats[t].weight,
+               stats[t].tiles, 100.0 * (double)stats[t].tiles / (double)total_tiles,
+               stats[t].busy, end - stats[t].finish);
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    if (argc < 4) {
+        fprintf(stderr, "Usage: %s <matrix_size> <num_threads> <block_size> "
+                        "[static|proportional|dynamic]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    int N           = atoi(argv[1]);
+    int num_threads = atoi(argv[2]);
+    int block_size  = atoi(argv[3]);
+    dist_mode mode  = DIST_PROPORTIONAL;
+
+    if (argc > 4) {
+        if      (strcmp(argv[4], "static") == 0)       mode = DIST_STATIC;
+        else if (strcmp(argv[4], "proportional") == 0) mode = DIST_PROPORTIONAL;
+        else if (strcmp(argv[4], "dynamic") == 0)      mode = DIST_DYNAMIC;
+        else {
+            fprintf(stderr, "Unknown distribution mode '%s'\n", argv[4]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    static core_type map[MAX_CPUS];
+    int sysfs_hybrid = detect_core_types_sysfs(map);
+
+    /* Line-aligned so each padded entry sits on its own cache line. */
+    thread_stats *stats = NULL;
+    if (posix_memalign((void**)&stats, 64, (size_t)num_threads * sizeof(thread_stats)) != 0) {
+        fprintf(stderr, "posix_memalign failed\n");
+        return EXIT_FAILURE;
+    }
+    memset(stats, 0, (size_t)num_threads * sizeof(thread_stats));
+
+    if (mode == DIST_PROPORTIONAL && omp_get_proc_bind() == omp_proc_bind_false) {
+        fprintf(stderr, "Note: threads are not bound; set OMP_PROC_BIND=true so the "
+                        "calibrated weights stay with their cores.\n");
+    }
+
+    calibrate(stats, num_threads, sysfs_hybrid, map);
+
+    double *A = aligned_alloc_doubles(N*N, 64);
+    double *B = aligned_alloc_doubles(N*N, 64);
+    double *C = aligned_alloc_doubles(N*N, 64);
+
+    srand((unsigned)time(NULL));
+
+    fill_random(A, N);
+    fill_random(B, N);
+
+    rapl_meter energy;
+    rapl_start(&energy);
+
+    double start = get_time_in_seconds();
+    matmul_hybrid(A, B, C, N, block_size, num_threads, mode, stats);
+    double end   = get_time_in_seconds();
+    double joules = rapl_stop(&energy);
+
+    /* Every tile must be computed exactly once whatever the distribution. */
+    double *Cref = aligned_alloc_doubles(N*N, 64);
+    matmul_blocked(A, B, Cref, N, block_size, num_threads);
+    double rel_diff = max_rel_diff(C, Cref, (size_t)N*N);
+
+    printf("[Hybrid] N=%d, threads=%d, block_size=%d, mode=%s, core_types=%s, "
+           "time=%f sec, max_rel_diff=%e",
+           N, num_threads, block_size, dist_mode_name(mode),
+           sysfs_hybrid ? "sysfs" : "cpuid", end - start, rel_diff);
+    rapl_print_fields(joules, end - start, 2.0 * N * N * N);
+    printf("\n");
+    print_report(stats, num_threads, end);
+
+    free(A);
+    free(B);
+    free(C);
+    free(Cref);
+    free(stats);
+
+    if (rel_diff > N * DBL_EPSILON) {
+        fprintf(stderr, "Result differs from matmul_blocked beyond N*eps\n");
+        return EXIT_FAILURE;
+    }
+    return 0;
+}
@@ -0,0 +1,545 @@
+/******************************************************************************
+ * File: matmul_incremental_parallel.c
+ *
+ * Description:
+ *   Incremental recomputation of C = A * B after small changes to A or B.
+ *   The state keeps A, B and the current product C; each update applies the
+ *   change to A or B and patches C with the least GEMM work instead of
+ *   redoing the full 2*N^3 product:
+ *
+ *     rows R of A replaced:    C[R,:] = A[R,:] * B               2|R| N^2
+ *     cols S of A replaced:    C += (A_new - A_old)[:,S] * B[S,:]  2|S| N^2
+ *     rows S of B replaced:    C += A[:,S] * (B_new - B_old)[S,:]  2|S| N^2
+ *     cols T of B replaced:    C[:,T] = A * B[:,T]               2|T| N^2
+ *     rank-k  A += U V^T:      C += U (V^T B)                    4k N^2
+ *     rank-k  B += U V^T:      C += (A U) V^T                    4k N^2
+ *
+ *   Changed rows/columns are gathered into contiguous panels and the
+ *   updates run through the cache-blocked kernel, generalised here to
+ *   rectangular operands with leading dimensions. When an update would cost
+ *   at least as much as a full recompute (e.g. rank k >= N/2), the change is
+ *   applied and C is recomputed with matmul_blocked() instead.
+ *
+ *   The driver reports the flops of each update, the work saved against a
+ *   full recompute, both times, and the largest difference from a fresh
+ *   full product.
+ *
+ * Compile:
+ *   gcc -fopenmp matmul_incremental_parallel.c -o matmul_incremental_parallel -O3 -lm
+ *
+ * Run:
+ *   ./matmul_incremental_parallel <matrix_size> <num_threads> <block_size>
+ *                                 [rows_a|cols_a|rows_b|cols_b|rank_a|rank_b|all]
+ *                                 [changed]
+ *****************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <omp.h>
+#include <string.h>
+#include <time.h>
+#include <math.h>
+
+/* Updated C vs. a full recompute after all modes have been applied. */
+#define MAX_REL_DIFF 1.0e-12
+
+static inline double* aligned_alloc_doubles(size_t N, size_t alignment)
+{
+    void *ptr = NULL;
+    int ret = posix_memalign(&ptr, alignment, N * sizeof(double));
+    if (ret != 0) {
+        fprintf(stderr, "posix_memalign failed\n");
+        exit(EXIT_FAILURE);
+    }
+    memset(ptr, 0, N * sizeof(double));
+    return (double*)ptr;
+}
+
+static inline void fill_random_n(double *v, size_t n)
+{
+    for (size_t i = 0; i < n; i++) {
+        v[i] = (double)rand() / (double)RAND_MAX;
+    }
+}
+
+static inline double get_time_in_seconds()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1.0e-9;
+}
+
+static inline int min_int(int a, int b) { return a < b ? a : b; }
+
+/******************************************************************************
+ * Full recompute: the blocked GEMM from matmul_blocked_parallel.c
+ *****************************************************************************/
+void matmul_blocked(double *A, double *B, double *C,
+                    int N, int block_size, int num_threads)
+{
+    int iBlock, jBlock, kBlock;
+    int i, j, k;
+    double sum;
+
+#pragma omp parallel for num_threads(num_threads) collapse(2) \
+    shared(A, B, C, N, block_size)                            \
+    private(iBlock, jBlock, kBlock, i, j, k, sum)
+    for (iBlock = 0; iBlock < N; iBlock += block_size) {
+        for (jBlock = 0; jBlock < N; jBlock += block_size) {
+            for (kBlock = 0; kBlock < N; kBlock += block_size) {
+
+                for (i = iBlock; i < iBlock + block_size && i < N; i++) {
+                    for (j = jBlock; j < jBlock + block_size && j < N; j++) {
+                        sum = C[i*N + j];
+                        for (k = kBlock; k < kBlock + block_size && k < N; k++) {
+                            sum += A[i*N + k] * B[k*N + j];
+                        }
+                        C[i*N + j] = sum;
+                    }
+                }
+            }
+        }
+    }
+}
+
+/******************************************************************************
+ * Rectangular blocked GEMM: C (M x N) += A (M x K) * B (K x N), row-major
+ * with leading dimensions. Same tiling as matmul_blocked, ikj inside a tile.
+ *****************************************************************************/
+static void gemm_acc(const double *A, int lda, const double *B, int ldb,
+                     double *C, int ldc, int M, int N, int K,
+                     int block_size, int num_threads)
+{
+#pragma omp parallel for num_threads(num_threads) collapse(2) schedule(static)
+    for (int iBlock = 0; iBlock < M; iBlock += block_size) {
+        for (int jBlock = 0; jBlock < N; jBlock += block_size) {
+            const int iEnd = min_int(iBlock + block_size, M);
+            const int jEnd = min_int(jBlock + block_size, N);
+
+            for (int kBlock = 0; kBlock < K; kBlock += block_size) {
+                const int kEnd = min_int(kBlock + block_size, K);
+
+                for (int i = iBlock; i < iEnd; i++) {
+                    double *c = C + (size_t)i*ldc;
+                    for (int k = kBlock; k < kEnd; k++) {
+                        const double  a = A[(size_t)i*lda + k];
+                        const double *b = B + (size_t)k*ldb;
+#pragma omp simd
+                        for (int j = jBlock; j < jEnd; j++) {
+                            c[j] += a * b[j];
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
+
+/******************************************************************************
+ * Incremental state
+ *****************************************************************************/
+typedef struct {
+    int     N;
+    int     block_size;
+    int     num_threads;
+    double *A, *B, *C;      /* caller's matrices; C == A*B between updates */
+    double  last_flops;     /* flops spent on C by the last update */
+    int     last_full;      /* 1 if the last update fell back to a full recompute */
+} incremental_state;
+
+static inline double full_flops(int N)
+{
+    return 2.0 * (double)N * (double)N * (double)N;
+}
+
+static void recompute_full(incremental_state *s)
+{
+    memset(s->C, 0, (size_t)s->N * s->N * sizeof(double));
+    matmul_blocked(s->A, s->B, s->C, s->N, s->block_size, s->num_threads);
+    s->last_flops = full_flops(s->N);
+    s->last_full  = 1;
+}
+
+void incremental_init(incremental_state *s, double *A, double *B, double *C,
+                      int N, int block_size, int num_threads)
+{
+    s->N           = N;
+    s->block_size  = block_size;
+    s->num_threads = num_threads;
+    s->A           = A;
+    s->B           = B;
+    s->C           = C;
+    recompute_full(s);
+}
+
+/* Indices must be distinct and in [0, N); returns 0 if so. */
+static int check_indices(const int *idx, int count, int N)
+{
+    unsigned char *seen;
+    int ok = 1;
+
+    if (count < 0 || count > N) return -1;
+    seen = (unsigned char*)calloc((size_t)N + 1, 1);
+    if (seen == NULL) {
+        fprintf(stderr, "calloc failed\n");
+        exit(EXIT_FAILURE);
+    }
+    for (int t = 0; t < count && ok; t++) {
+        ok = idx[t] >= 0 && idx[t] < N && !seen[idx[t]];
+        if (ok) seen[idx[t]] = 1;
+    }
+    free(seen);
+    return ok ? 0 : -1;
+}
+
+/* Rows `rows` of A become new_rows (count x N). */
+int incremental_rows_A(incremental_state *s, const int *rows, int count,
+                       const double *new_rows)
+{
+    const int N = s->N;
+    double *c_rows;
+
+    if (check_indices(rows, count, N) != 0) return -1;
+    for (int t = 0; t < count; t++) {
+        memcpy(s->A + (size_t)rows[t]*N, new_rows + (size_t)t*N, N * sizeof(double));
+    }
+    s->last_full = 0;
+    if (2.0 * count * (double)N * N >= full_flops(N)) {
+        recompute_full(s);
+        return 0;
+    }
+
+    c_rows = aligned_alloc_doubles((size_t)count * N, 64);
+    gemm_acc(new_rows, N, s->B, N, c_rows, N, count, N, N, s->block_size, s->num_threads);
+    for (int t = 0; t < count; t++) {
+        memcpy(s->C + (size_t)rows[t]*N, c_rows + (size_t)t*N, N * sizeof(double));
+    }
+    free(c_rows);
+    s->last_flops = 2.0 * count * (double)N * N;
+    return 0;
+}
+
+/* Columns `cols` of A become new_cols (N x count, row-major). */
+int incremental_cols_A(incremental_state *s, const int *cols, int count,
+                       const double *new_cols)
+{
+    const int N = s->N;
+    double *delta, *b_rows;
+
+    if (check_indices(cols, count, N) != 0) return -1;
+    s->last_full = 0;
+    if (2.0 * count * (double)N * N >= full_flops(N)) {
+        for (int i = 0; i < N; i++) {
+            for (int t = 0; t < count; t++) {
+                s->A[(size_t)i*N + cols[t]] = new_cols[(size_t)i*count + t];
+            }
+        }
+        recompute_full(s);
+        return 0;
+    }
+
+    /* delta = new - old (N x count), b_rows = B[cols,:] (count x N) */
+    delta  = aligned_alloc_doubles((size_t)N * count, 64);
+    b_rows = aligned_alloc_doubles((size_t)count * N, 64);
+    for (int i = 0; i < N; i++) {
+        for (int t = 0; t < count; t++) {
+            double *a = s->A + (size_t)i*N + cols[t];
+            delta[(size_t)i*count + t] = new_cols[(size_t)i*count + t] - *a;
+            *a = new_cols[(size_t)i*count + t];
+        }
+    }
+    for (int t = 0; t < count; t++) {
+        memcpy(b_rows + (size_t)t*N, s->B + (size_t)cols[t]*N, N * sizeof(double));
+    }
+    gemm_acc(delta, count, b_rows, N, s->C, N, N, N, count, s->block_size, s->num_threads);
+    free(delta);
+    free(b_rows);
+    s->last_flops = 2.0 * count * (double)N * N;
+    return 0;
+}
+
+/* Rows `rows` of B become new_rows (count x N). */
+int incremental_rows_B(incremental_state *s, const int *rows, int count,
+                       const double *new_rows)
+{
+    const int N = s->N;
+    double *a_cols, *delta;
+
+    if (check_indices(rows, count, N) != 0) return -1;
+    s->last_full = 0;
+    if (2.0 * count * (double)N * N >= full_flops(N)) {
+        for (int t = 0; t < count; t++) {
+            memcpy(s->B + (size_t)rows[t]*N, new_rows + (size_t)t*N, N * sizeof(double));
+        }
+        recompute_full(s);
+        return 0;
+    }
+
+    /* a_cols = A[:,rows] (N x count), delta = new - old (count x N) */
+    a_cols = aligned_alloc_doubles((size_t)N * count, 64);
+    delta  = aligned_alloc_doubles((size_t)count * N, 64);
+    for (int i = 0; i < N; i++) {
+        for (int t = 0; t < count; t++) {
+            a_cols[(size_t)i*count + t] = s->A[(size_t)i*N + rows[t]];
+        }
+    }
+    for (int t = 0; t < count; t++) {
+        double *b = s->B + (size_t)rows[t]*N;
+        for (int j = 0; j < N; j++) {
+            delta[(size_t)t*N + j] = new_rows[(size_t)t*N + j] - b[j];
+            b[j] = new_rows[(size_t)t*N + j];
+        }
+    }
+    gemm_acc(a_cols, count, delta, N, s->C, N, N, N, count, s->block_size, s->num_threads);
+    free(a_cols);
+    free(delta);
+    s->last_flops = 2.0 * count * (double)N * N;
+    return 0;
+}
+
+/* Columns `cols` of B become new_cols (N x count, row-major). */
+int incremental_cols_B(incremental_state *s, const int *cols, int count,
+                       const double *new_cols)
+{
+    const int N = s->N;
+    double *c_cols;
+
+    if (check_indices(cols, count, N) != 0) return -1;
+    for (int k = 0; k < N; k++) {
+        for (int t = 0; t < count; t++) {
+            s->B[(size_t)k*N + cols[t]] = new_cols[(size_t)k*count + t];
+        }
+    }
+    s->last_full = 0;
+    if (2.0 * count * (double)N * N >= full_flops(N)) {
+        recompute_full(s);
+        return 0;
+    }
+
+    c_cols = aligned_alloc_doubles((size_t)N * count, 64);
+    gemm_acc(s->A, N, new_cols, count, c_cols, count, N, count, N,
+             s->block_size, s->num_threads);
+    for (int i = 0; i < N; i++) {
+        for (int t = 0; t < count; t++) {
+            s->C[(size_t)i*N + cols[t]] = c_cols[(size_t)i*count + t];
+        }
+    }
+    free(c_cols);
+    s->last_flops = 2.0 * count * (double)N * N;
+    return 0;
+}
+
+/* X += U V^T for N x k panels U, V (row-major). */
+static void rank_k_apply(double *X, const double *U, const double *V, int N, int k,
+                         int num_threads)
+{
+#pragma omp parallel for num_threads(num_threads) schedule(static)
+    for (int i = 0; i < N; i++) {
+        double *x = X + (size_t)i*N;
+        for (int r = 0; r < k; r++) {
+            const double u = U[(size_t)i*k + r];
+            for (int j = 0; j < N; j++) {
+                x[j] += u * V[(size_t)j*k + r];
+            }
+        }
+    }
+}
+
+/* A += U V^T, with U and V N x k: C += U (V^T B). */
+int incremental_rank_A(incremental_state *s, const double *U, const double *V, int k)
+{
+    const int N = s->N;
+    double *Vt, *W;
+
+    if (k < 0) return -1;
+    rank_k_apply(s->A, U, V, N, k, s->num_threads);
+    s->last_full = 0;
+    if (4.0 * k * (double)N * N >= full_flops(N)) {
+        recompute_full(s);
+        return 0;
+    }
+
+    /* W = V^T B (k x N), then C += U W */
+    Vt = aligned_alloc_doubles((size_t)k * N, 64);
+    W  = aligned_alloc_doubles((size_t)k * N, 64);
+    for (int i = 0; i < N; i++) {
+        for (int r = 0; r < k; r++) {
+            Vt[(size_t)r*N + i] = V[(size_t)i*k + r];
+        }
+    }
+    gemm_acc(Vt, N, s->B, N, W, N, k, N, N, s->block_size, s->num_threads);
+    gemm_acc(U, k, W, N, s->C, N, N, N, k, s->block_size, s->num_threads);
+    free(Vt);
+    free(W);
+    s->last_flops = 4.0 * k * (double)N * N;
+    return 0;
+}
+
+/* B += U V^T, with U and V N x k: C += (A U) V^T. */
+int incremental_rank_B(incremental_state *s, const double *U, const double *V, int k)
+{
+    const int N = s->N;
+    double *Vt, *W;
+
+    if (k < 0) return -1;
+    rank_k_apply(s->B, U, V, N, k, s->num_threads);
+    s->last_full = 0;
+    if (4.0 * k * (double)N * N >= full_flops(N)) {
+        recompute_full(s);
+        return 0;
+    }
+
+    /* W = A U (N x k), then C += W V^T */
+    Vt = aligned_alloc_doubles((size_t)k * N, 64);
+    W  = aligned_alloc_doubles((size_t)N * k, 64);
+    for (int i = 0; i < N; i++) {
+        for (int r = 0; r < k; r++) {
+            Vt[(size_t)r*N + i] = V[(size_t)i*k + r];
+        }
+    }
+    gemm_acc(s->A, N, U, k, W, k, N, k, N, s->block_size, s->num_threads);
+    gemm_acc(W, k, Vt, N, s->C, N, N, N, k, s->block_size, s->num_threads);
+    free(Vt);
+    free(W);
+    s->last_flops = 4.0 * k * (double)N * N;
+    return 0;
+}
+
+/******************************************************************************
+ * Benchmark driver
+ *****************************************************************************/
+
+/* `count` distinct random indices in [0, N) (partial Fisher-Yates). */
+static void random_indices(int *idx, int count, int N)
+{
+    int *perm = (int*)malloc((size_t)N * sizeof(int));
+    if (perm == NULL) {
+        fprintf(stderr, "malloc failed\n");
+        exit(EXIT_FAILURE);
+    }
+    for (int i = 0; i < N; i++) perm[i] = i;
+    for (int t = 0; t < count; t++) {
+        int r = t + rand() % (N - t);
+        int tmp = perm[t];
+        perm[t] = perm[r];
+        perm[r] = tmp;
+        idx[t] = perm[t];
+    }
+    free(perm);
+}
+
+static double max_rel_diff(const double *X, const double *Y, size_t n)
+{
+    double max_diff = 0.0, max_ref = 0.0;
+    for (size_t i = 0; i < n; i++) {
+        double d = fabs(X[i] - Y[i]);
+        if (d > max_diff) max_diff = d;
+        if (fabs(Y[i]) > max_ref) max_ref = fabs(Y[i]);
+    }
+    return max_ref > 0.0 ? max_diff / max_ref : max_diff;
+}
+
+int main(int argc, char* argv[])
+{
+    static const char *MODES[] = { "rows_a", "cols_a", "rows_b", "cols_b", "rank_a", "rank_b" };
+    const int num_modes = (int)(sizeof(MODES) / sizeof(MODES[0]));
+
+    if (argc < 4) {
+        fprintf(stderr, "Usage: %s <matrix_size> <num_threads> <block_size> "
+                        "[rows_a|cols_a|rows_b|cols_b|rank_a|rank_b|all] [changed]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    int N           = atoi(argv[1]);
+    int num_threads = atoi(argv[2]);
+    int block_size  = atoi(argv[3]);
+    const char *mode = (argc > 4) ? argv[4] : "all";
+    int changed      = (argc > 5) ? atoi(argv[5]) : 8;
+    int selected     = -1;
+
+    if (strcmp(mode, "all") != 0) {
+        for (int m = 0; m < num_modes; m++) {
+            if (strcmp(mode, MODES[m]) == 0) selected = m;
+        }
+        if (selected < 0) {
+            fprintf(stderr, "Unknown mode '%s'\n", mode);
+            return EXIT_FAILURE;
+        }
+    }
+    if (N <= 0 || changed < 1 || changed > N) {
+        fprintf(stderr, "Need N > 0 and 1 <= changed <= N\n");
+        return EXIT_FAILURE;
+    }
+
+    double *A    = aligned_alloc_doubles((size_t)N*N, 64);
+    double *B    = aligned_alloc_doubles((size_t)N*N, 64);
+    double *C    = aligned_alloc_doubles((size_t)N*N, 64);
+    double *Cref = aligned_alloc_doubles((size_t)N*N, 64);
+    double *U    = aligned_alloc_doubles((size_t)N*changed, 64);
+    double *V    = aligned_alloc_doubles((size_t)N*changed, 64);
+    int    *idx  = (int*)malloc((size_t)changed * sizeof(int));
+    incremental_state state;
+    int failures = 0;
+
+    if (idx == NULL) {
+        fprintf(stderr, "malloc failed\n");
+        return EXIT_FAILURE;
+    }
+
+    srand((unsigned)time(NULL));
+
+    fill_random_n(A, (size_t)N*N);
+    fill_random_n(B, (size_t)N*N);
+    incremental_init(&state, A, B, C, N, block_size, num_threads);
+
+    for (int m = 0; m < num_modes; m++) {
+        if (selected >= 0 && m != selected) continue;
+
+        /* New row/column contents (changed x N or N x changed) and U, V. */
+        fill_random_n(U, (size_t)N*changed);
+        fill_random_n(V, (size_t)N*changed);
+        random_indices(idx, changed, N);
+
+        double start = get_time_in_seconds();
+        switch (m) {
+        case 0:  incremental_rows_A(&state, idx, changed, U); break;
+        case 1:  incremental_cols_A(&state, idx, changed, U); break;
+        case 2:  incremental_rows_B(&state, idx, changed, U); break;
+        case 3:  incremental_cols_B(&state, idx, changed, U); break;
+        case 4:  incremental_rank_A(&state, U, V, changed);   break;
+        default: incremental_rank_B(&state, U, V, changed);   break;
+        }
+        double inc_time = get_time_in_seconds() - start;
+
+        memset(Cref, 0, (size_t)N*N * sizeof(double));
+        start = get_time_in_seconds();
+        matmul_blocked(A, B, Cref, N, block_size, num_threads);
+        double full_time = get_time_in_seconds() - start;
+        double rel_diff  = max_rel_diff(C, Cref, (size_t)N*N);
+
+        printf("[Incremental] N=%d, threads=%d, block_size=%d, mode=%s, changed=%d, "
+               "path=%s, flops=%.0f, full_flops=%.0f, work_saved=%.2f%%, "
+               "time=%f sec, full_time=%f sec, speedup=%.2fx, max_rel_diff=%e\n",
+               N, num_threads, block_size, MODES[m], changed,
+               state.last_full ? "full" : "incremental",
+               state.last_flops, full_flops(N),
+               100.0 * (1.0 - state.last_flops / full_flops(N)),
+               inc_time, full_time, full_time / inc_time, rel_diff);
+        failures += rel_diff > MAX_REL_DIFF;
+    }
+
+    free(A);
+    free(B);
+    free(C);
+    free(Cref);
+    free(U);
+    free(V);
+    free(idx);
+
+    if (failures > 0) {
+        fprintf(stderr, "Updated C differs from the full recompute beyond %g\n",
+                MAX_REL_DIFF);
+        return EXIT_FAILURE;
+    }
+    return 0;
+}
@@ -0,0 +1,529 @@
+/******************************************************************************
+ * File: matmul_layout_parallel.c
+ *
+ * Description:
+ *   Tiled and Morton (Z-order) storage layouts, a parallel cache-oblivious
+ *   layout converter, and a blocked multiplication that runs directly on
+ *   tiled storage.
+ *
+ *   Layouts of an N x N matrix:
+ *     row-major  A[i*N + j]
+ *     col-major  A[j*N + i]
+ *     tiled      T x T tiles stored contiguously (row-major inside a tile),
+ *                tiles in row-major tile order
+ *     morton     same tiles, ordered along the Z-order curve of their
+ *                (tile_row, tile_col) coordinates, so tiles that are close in
+ *                2-D are close in memory at every scale
+ *   Tiled layouts are padded to a whole number of tiles; the padding is zero
+ *   and never written, so kernels can run full T x T tiles with no edge code.
+ *
+ *   Converter: layout_convert() copies (or transposes) between any two
+ *   layouts. It recurses over the tile grid, halving the longer side each
+ *   time (a Z-order walk, so it is cache-oblivious and writes Morton
+ *   destinations sequentially), and spawns OpenMP tasks down to a cutoff.
+ *   Each leaf is one tile: a unit-stride row copy when both sides agree,
+ *   otherwise an 8 x 8 blocked transpose; inner loops are 'omp simd'.
+ *
+ *   Kernel: matmul_tiled() multiplies matrices stored tiled or Morton. Every
+ *   operand tile is a contiguous T*T block, so B tiles get full spatial
+ *   locality instead of spanning T rows of stride N.
+ *
+ *   The driver converts A and B once, reuses them over several
+ *   multiplications, converts C back, and compares against the row-major
+ *   matmul_blocked(); it also reports converter bandwidth.
+ *
+ * Compile:
+ *   gcc -fopenmp matmul_layout_parallel.c -o matmul_layout_parallel -O3 -lm
+ *
+ * Run:
+ *   ./matmul_layout_parallel <matrix_size> <num_threads> <tile_size> [reps]
+ *****************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <omp.h>
+#include <string.h>
+#include <time.h>
+#include <math.h>
+#include <float.h>
+
+#define CONVERT_GRID        32    /* virtual tile for row-major <-> col-major */
+#define CONVERT_TASK_TILES  16    /* stop spawning tasks below this many tiles */
+#define TRANSPOSE_BLOCK     8
+
+static inline double* aligned_alloc_doubles(size_t N, size_t alignment)
+{
+    void *ptr = NULL;
+    int ret = posix_memalign(&ptr, alignment, N * sizeof(double));
+    if (ret != 0) {
+        fprintf(stderr, "posix_memalign failed\n");
+        exit(EXIT_FAILURE);
+    }
+    memset(ptr, 0, N * sizeof(double));
+    return (double*)ptr;
+}
+
+static inline void fill_random(double *mat, int N)
+{
+    for (int i = 0; i < N*N; i++) {
+        mat[i] = (double)rand() / (double)RAND_MAX;
+    }
+}
+
+static inline double get_time_in_seconds()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1.0e-9;
+}
+
+static inline int min_int(int a, int b) { return a < b ? a : b; }
+
+/******************************************************************************
+ * Baseline: the blocked GEMM from matmul_blocked_parallel.c
+ *****************************************************************************/
+void matmul_blocked(double *A, double *B, double *C,
+                    int N, int block_size, int num_threads)
+{
+    int iBlock, jBlock, kBlock;
+    int i, j, k;
+    double sum;
+
+#pragma omp parallel for num_threads(num_threads) collapse(2) \
+    shared(A, B, C, N, block_size)                            \
+    private(iBlock, jBlock, kBlock, i, j, k, sum)
+    for (iBlock = 0; iBlock < N; iBlock += block_size) {
+        for (jBlock = 0; jBlock < N; jBlock += block_size) {
+            for (kBlock = 0; kBlock < N; kBlock += block_size) {
+
+                for (i = iBlock; i < iBlock + block_size && i < N; i++) {
+                    for (j = jBlock; j < jBlock + block_size && j < N; j++) {
+                        sum = C[i*N + j];
+                        for (k = kBlock; k < kBlock + block_size && k < N; k++) {
+                            sum += A[i*N + k] * B[k*N + j];
+                        }
+                        C[i*N + j] = sum;
+                    }
+                }
+            }
+        }
+    }
+}
+
+/******************************************************************************
+ * Layouts
+ *****************************************************************************/
+typedef enum { LAYOUT_ROW_MAJOR, LAYOUT_COL_MAJOR, LAYOUT_TILED, LAYOUT_MORTON } layout_kind;
+
+static const char* layout_name(layout_kind kind)
+{
+    static const char *names[] = { "row_major", "col_major", "tiled", "morton" };
+    return names[kind];
+}
+
+typedef struct {
+    layout_kind  kind;
+    int          N;
+    int          tile;          /* tile edge (tiled/morton only) */
+    int          nb;            /* tiles per dimension */
+    size_t      *tile_offset;   /* nb*nb element offsets of tile (ti, tj) */
+    double      *data;
+} layout_matrix;
+
+static inline int is_tiled(layout_kind kind)
+{
+    return kind == LAYOUT_TILED || kind == LAYOUT_MORTON;
+}
+
+/* Split a Z-order code ...i1 j1 i0 j0 into tile coordinates (ti, tj). */
+static inline void morton_decode(unsigned long long code, unsigned *ti, unsigned *tj)
+{
+    *ti = *tj = 0;
+    for (int b = 0; b < 32; b++) {
+        *tj |= (unsigned)((code >> (2*b)) & 1u) << b;
+        *ti |= (unsigned)((code >> (2*b + 1)) & 1u) << b;
+    }
+}
+
+/*
+ * Zeroed N x N matrix in the given layout. For Morton, tiles are ranked in
+ * Z-order over the enclosing power-of-two grid, skipping codes outside the
+ * nb x nb grid, so storage stays compact when nb is not a power of two.
+ */
+void layout_alloc(layout_matrix *m, layout_kind kind, int N, int tile)
+{
+    memset(m, 0, sizeof(*m));
+    m->kind = kind;
+    m->N    = N;
+
+    if (!is_tiled(kind)) {
+        m->data = aligned_alloc_doubles((size_t)N * N, 64);
+        return;
+    }
+
+    m->tile        = tile;
+    m->nb          = (N + tile - 1) / tile;
+    m->data        = aligned_alloc_doubles((size_t)m->nb * m->nb * tile * tile, 64);
+    m->tile_offset = (size_t*)malloc((size_t)m->nb * m->nb * sizeof(size_t));
+    if (m->tile_offset == NULL) {
+        fprintf(stderr, "malloc failed\n");
+        exit(EXIT_FAILURE);
+    }
+
+    const size_t tile_elems = (size_t)tile * tile;
+    if (kind == LAYOUT_TILED) {
+        for (size_t t = 0; t < (size_t)m->nb * m->nb; t++) {
+            m->tile_offset[t] = t * tile_elems;
+        }
+    } else {
+        unsigned p = 1;
+        size_t rank = 0;
+        while ((int)p < m->nb) p <<= 1;
+        for (unsigned long long code = 0; code < (unsigned long long)p * p; code++) {
+            unsigned ti, tj;
+            morton_decode(code, &ti, &tj);
+            if ((int)ti < m->nb && (int)tj < m->nb) {
+                m->tile_offset[(size_t)ti * m->nb + tj] = rank++ * tile_elems;
+            }
+        }
+    }
+}
+
+void layout_free(layout_matrix *m)
+{
+    free(m->data);
+    free(m->tile_offset);
+    memset(m, 0, sizeof(*m));
+}
+
+/* A grid x grid block at block coordinates (bi, bj) as pointer + strides. */
+typedef struct {
+    double *ptr;
+    long    rs, cs;     /* element strides between rows / columns */
+} block_view;
+
+static inline block_view layout_block(const layout_matrix *m, int bi, int bj, int grid)
+{
+    block_view v;
+    switch (m->kind) {
+    case LAYOUT_ROW_MAJOR:
+        v.ptr = m->data + (size_t)bi * grid * m->N + (size_t)bj * grid;
+        v.rs  = m->N;
+        v.cs  = 1;
+        break;
+    case LAYOUT_COL_MAJOR:
+        v.ptr = m->data + (size_t)bj * grid * m->N + (size_t)bi * grid;
+        v.rs  = 1;
+        v.cs  = m->N;
+        break;
+    default:
+        v.ptr = m->data + m->tile_offset[(size_t)bi * m->nb + bj];
+        v.rs  = m->tile;
+        v.cs  = 1;
+        break;
+    }
+    return v;
+}
+
+/******************************************************************************
+ * Converter
+ *****************************************************************************/
+
+/* dst(i, j) = src(i, j) for a rows x cols block; dst has unit column stride. */
+static void copy_block(double *dst, long drs, const double *src, long srs, long scs,
+                       int rows, int cols)
+{
+    if (scs == 1) {
+        for (int i = 0; i < rows; i++) {
+            double *d       = dst + i * drs;
+            const double *s = src + i * srs;
+#pragma omp simd
+            for (int j = 0; j < cols; j++) {
+                d[j] = s[j];
+            }
+        }
+        return;
+    }
+
+    /* Transposing copy: 8 x 8 sub-blocks keep both sides within a few lines. */
+    for (int ii = 0; ii < rows; ii += TRANSPOSE_BLOCK) {
+        for (int jj = 0; jj < cols; jj += TRANSPOSE_BLOCK) {
+            const int iEnd = min_int(ii + TRANSPOSE_BLOCK, rows);
+            const int jEnd = min_int(jj + TRANSPOSE_BLOCK, cols);
+            for (int i = ii; i < iEnd; i++) {
+                double *d       = dst + i * drs;
+                const double *s = src + i * srs;
+#pragma omp simd
+                for (int j = jj; j < jEnd; j++) {
+                    d[j] = s[j * scs];
+                }
+            }
+        }
+    }
+}
+
+typedef struct {
+    const layout_matrix *src;
+    layout_matrix       *dst;
+    int                  grid;
+    int                  transpose;
+} convert_ctx;
+
+/* One destination block (bi, bj). */
+static void convert_leaf(const convert_ctx *ctx, int bi, int bj)
+{
+    const int N    = ctx->dst->N;
+    const int rows = min_int(ctx->grid, N - bi * ctx->grid);
+    const int cols = min_int(ctx->grid, N - bj * ctx->grid);
+    block_view d   = layout_block(ctx->dst, bi, bj, ctx->grid);
+    block_view s;
+
+    if (ctx->transpose) {
+        /* dst(i, j) = src(j, i): the source block (bj, bi) read with swapped strides */
+        block_view t = layout_block(ctx->src, bj, bi, ctx->grid);
+        s.ptr = t.ptr;
+        s.rs  = t.cs;
+        s.cs  = t.rs;
+    } else {
+        s = layout_block(ctx->src, bi, bj, ctx->grid);
+    }
+
+    if (d.cs == 1) {
+        copy_block(d.ptr, d.rs, s.ptr, s.rs, s.cs, rows, cols);
+    } else {
+        /* Column-major destination: copy the transposed problem. */
+        copy_block(d.ptr, d.cs, s.ptr, s.cs, s.rs, cols, rows);
+    }
+}
+
+/* Cache-oblivious walk of blocks [bi0, bi1) x [bj0, bj1), longest side first. */
+static void convert_rec(const convert_ctx *ctx, int bi0, int bi1, int bj0, int bj1)
+{
+    const int h = bi1 - bi0;
+    const int w = bj1 - bj0;
+
+    if (h <= 0 || w <= 0) return;
+    if (h == 1 && w == 1) {
+        convert_leaf(ctx, bi0, bj0);
+        return;
+    }
+
+    if (h * w > CONVERT_TASK_TILES) {
+        if (h >= w) {
+#pragma omp task firstprivate(ctx, bi0, bi1, bj0, bj1, h)
+            convert_rec(ctx, bi0, bi0 + h/2, bj0, bj1);
+            convert_rec(ctx, bi0 + h/2, bi1, bj0, bj1);
+        } else {
+#pragma omp task firstprivate(ctx, bi0, bi1, bj0, bj1, w)
+            convert_rec(ctx, bi0, bi1, bj0, bj0 + w/2);
+            convert_rec(ctx, bi0, bi1, bj0 + w/2, bj1);
+        }
+#pragma omp taskwait
+    } else if (h >= w) {
+        convert_rec(ctx, bi0, bi0 + h/2, bj0, bj1);
+        convert_rec(ctx, bi0 + h/2, bi1, bj0, bj1);
+    } else {
+        convert_rec(ctx, bi0, bi1, bj0, bj0 + w/2);
+        convert_rec(ctx, bi0, bi1, bj0 + w/2, bj1);
+    }
+}
+
+/*
+ * dst = src (or src^T with transpose != 0) across layouts. Returns -1 if the
+ * sizes differ, or if both sides are tiled with different tile sizes.
+ */
+int layout_convert(const layout_matrix *src, layout_matrix *dst, int transpose,
+                   int num_threads)
+{
+    convert_ctx ctx;
+    int nb;
+
+    if (src->N != dst->N) return -1;
+    if (is_tiled(src->kind) && is_tiled(dst->kind) && src->tile != dst->tile) return -1;
+
+    ctx.src       = src;
+    ctx.dst       = dst;
+    ctx.transpose = transpose;
+    ctx.grid      = is_tiled(dst->kind) ? dst->tile
+                  : is_tiled(src->kind) ? src->tile : CONVERT_GRID;
+    nb = (dst->N + ctx.grid - 1) / ctx.grid;
+
+#pragma omp parallel num_threads(num_threads)
+#pragma omp single
+    convert_rec(&ctx, 0, nb, 0, nb);
+
+    return 0;
+}
+
+/******************************************************************************
+ * Multiplication on tiled / Morton storage: C = A * B, all three in the same
+ * tiled layout. Every tile is a contiguous, zero-padded T x T block.
+ *****************************************************************************/
+void matmul_tiled(const layout_matrix *A, const layout_matrix *B, layout_matrix *C,
+                  int num_threads)
+{
+    const int T  = C->tile;
+    const int nb = C->nb;
+
+#pragma omp parallel for num_threads(num_threads) collapse(2) schedule(static)
+    for (int ti = 0; ti < nb; ti++) {
+        for (int tj = 0; tj < nb; tj++) {
+            double *c = C->data + C->tile_offset[(size_t)ti * nb + tj];
+
+            memset(c, 0, (size_t)T * T * sizeof(double));
+            for (int tk = 0; tk < nb; tk++) {
+                const double *a = A->data + A->tile_offset[(size_t)ti * nb + tk];
+                const double *b = B->data + B->tile_offset[(size_t)tk * nb + tj];
+
+                for (int i = 0; i < T; i++) {
+                    double *c_row = c + (size_t)i * T;
+                    for (int k = 0; k < T; k++) {
+                        const double  aik   = a[(size_t)i * T + k];
+                        const double *b_row = b + (size_t)k * T;
+#pragma omp simd
+                        for (int j = 0; j < T; j++) {
+                            c_row[j] += aik * b_row[j];
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
+
+/******************************************************************************
+ * Benchmark driver
+ *****************************************************************************/
+static double max_abs_diff(const double *X, const double *Y, size_t n)
+{
+    double max_diff = 0.0;
+    for (size_t i = 0; i < n; i++) {
+        double d = fabs(X[i] - Y[i]);
+        if (d > max_diff) max_diff = d;
+    }
+    return max_diff;
+}
+
+/* Round trips row-major -> every layout (plain and transposed) -> row-major. */
+static int check_converter(const layout_matrix *A, int tile, int num_threads)
+{
+    const int N = A->N;
+    layout_matrix back, mid;
+    int failures = 0;
+
+    layout_alloc(&back, LAYOUT_ROW_MAJOR, N, 0);
+    for (int kind = LAYOUT_ROW_MAJOR; kind <= LAYOUT_MORTON; kind++) {
+        for (int transpose = 0; transpose <= 1; transpose++) {
+            layout_alloc(&mid, (layout_kind)kind, N, tile);
+            layout_convert(A, &mid, transpose, num_threads);
+            layout_convert(&mid, &back, transpose, num_threads);
+            if (max_abs_diff(back.data, A->data, (size_t)N * N) != 0.0) {
+                fprintf(stderr, "Converter round trip via %s%s failed\n",
+                        layout_name((layout_kind)kind), transpose ? " (transposed)" : "");
+                failures++;
+            }
+            layout_free(&mid);
+        }
+    }
+    layout_free(&back);
+    return failures;
+}
+
+int main(int argc, char* argv[])
+{
+    if (argc < 4) {
+        fprintf(stderr, "Usage: %s <matrix_size> <num_threads> <tile_size> [reps]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    int N           = atoi(argv[1]);
+    int num_threads = atoi(argv[2]);
+    int tile        = atoi(argv[3]);
+    int reps        = (argc > 4) ? atoi(argv[4]) : 3;
+    double bytes    = 2.0 * (double)N * N * sizeof(double);
+
+    if (N <= 0 || tile <= 0 || reps <= 0) {
+        fprintf(stderr, "matrix_size, tile_size and reps must be positive\n");
+        return EXIT_FAILURE;
+    }
+
+    layout_matrix A, B, C, Cref;
+    layout_alloc(&A, LAYOUT_ROW_MAJOR, N, 0);
+    layout_alloc(&B, LAYOUT_ROW_MAJOR, N, 0);
+    layout_alloc(&C, LAYOUT_ROW_MAJOR, N, 0);
+    layout_alloc(&Cref, LAYOUT_ROW_MAJOR, N, 0);
+
+    srand((unsigned)time(NULL));
+
+    fill_random(A.data, N);
+    fill_random(B.data, N);
+
+    int failures = check_converter(&A, tile, num_threads);
+    if (failures != 0) goto done;
+
+    double start = get_time_in_seconds();
+    matmul_blocked(A.data, B.data, Cref.data, N, tile, num_threads);
+    double blocked_time = get_time_in_seconds() - start;
+    printf("[Layout] N=%d, threads=%d, tile=%d, layout=row_major, kernel=blocked, "
+           "time=%f sec\n", N, num_threads, tile, blocked_time);
+
+    /* Converter bandwidth on a plain transpose (row-major -> col-major). */
+    {
+        layout_matrix T;
+        layout_alloc(&T, LAYOUT_COL_MAJOR, N, 0);
+        start = get_time_in_seconds();
+        layout_convert(&A, &T, 0, num_threads);
+        double t = get_time_in_seconds() - start;
+        printf("[Layout] N=%d, threads=%d, convert=row_major->col_major, time=%f sec, "
+               "GB/s=%.3f\n", N, num_threads, t, bytes / t * 1.0e-9);
+        layout_free(&T);
+    }
+
+    for (int kind = LAYOUT_TILED; kind <= LAYOUT_MORTON; kind++) {
+        layout_matrix At, Bt, Ct;
+        layout_alloc(&At, (layout_kind)kind, N, tile);
+        layout_alloc(&Bt, (layout_kind)kind, N, tile);
+        layout_alloc(&Ct, (layout_kind)kind, N, tile);
+
+        start = get_time_in_seconds();
+        layout_convert(&A, &At, 0, num_threads);
+        layout_convert(&B, &Bt, 0, num_threads);
+        double to_time = get_time_in_seconds() - start;
+
+        start = get_time_in_seconds();
+        for (int r = 0; r < reps; r++) {
+            matmul_tiled(&At, &Bt, &Ct, num_threads);
+        }
+        double mm_time = (get_time_in_seconds() - start) / reps;
+
+        start = get_time_in_seconds();
+        layout_convert(&Ct, &C, 0, num_threads);
+        double from_time = get_time_in_seconds() - start;
+        double max_diff  = max_abs_diff(C.data, Cref.data, (size_t)N * N);
+
+        printf("[Layout] N=%d, threads=%d, tile=%d, layout=%s, kernel=tiled, "
+               "time=%f sec, convert_in=%f sec (GB/s=%.3f), convert_out=%f sec, "
+               "speedup_vs_blocked=%.2fx, max_diff=%e\n",
+               N, num_threads, tile, layout_name((layout_kind)kind), mm_time,
+               to_time, 2.0 * bytes / to_time * 1.0e-9, from_time,
+               blocked_time / mm_time, max_diff);
+        /* Entries are at most N (inputs in [0, 1]): allow N*eps relative to that. */
+        failures += max_diff > (double)N * N * DBL_EPSILON;
+
+        layout_free(&At);
+        layout_free(&Bt);
+        layout_free(&Ct);
+    }
+
+done:
+    layout_free(&A);
+    layout_free(&B);
+    layout_free(&C);
+    layout_free(&Cref);
+
+    if (failures > 0) {
+        fprintf(stderr, "Layout results differ from the row-major reference\n");
+        return EXIT_FAILURE;
+    }
+    return 0;
+}
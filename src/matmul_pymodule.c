@@ -0,0 +1,636 @@
+/******************************************************************************
+ * File: matmul_pymodule.c
+ *
+ * Description:
+ *   Python extension exposing the parallel kernels to NumPy (or any other
+ *   object that implements the buffer protocol) without going through files
+ *   or extra copies.
+ *
+ *     import numpy as np, matmul
+ *     C = np.asarray(matmul.matmul(A, B, kernel="blocked", threads=8))
+ *     matmul.matmul(A, B, out=C)           # reuse an existing result array
+ *
+ *   Inputs are used in place when they are 2-D float64 with unit-stride
+ *   rows, a non-negative row stride and the alignment the kernel needs
+ *   (8 bytes, or 64 bytes per row for kernel="aligned"). That covers
+ *   C-contiguous arrays and row slices such as A[:, :k] or A[::2]. Anything
+ *   else (float32, Fortran order, transposed views, misaligned data, or an
+ *   input that overlaps `out`) is copied once into a 64-byte aligned buffer.
+ *   matmul.stats() reports how many operands took each path.
+ *
+ *   The kernels are the ones from matmul_*_parallel.c, generalised to
+ *   rectangular operands with a leading dimension (row stride) so that
+ *   strided views need no copy. The GIL is released while they run, so other
+ *   Python threads keep going during a multiply.
+ *
+ *   Without `out` the result is a matmul.Matrix, a small 64-byte aligned
+ *   buffer object; np.asarray() wraps it without copying.
+ *
+ * Compile:
+ *   gcc -fopenmp -O3 -shared -fPIC $(python3-config --includes) \
+ *       matmul_pymodule.c -o matmul$(python3-config --extension-suffix)
+ *   (or: make python)
+ *****************************************************************************/
+
+#define PY_SSIZE_T_CLEAN
+#include <Python.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <omp.h>
+
+#define MATMUL_ALIGNMENT  64
+
+static inline double* aligned_alloc_doubles(size_t N, size_t alignment)
+{
+    void *ptr = NULL;
+    if (N == 0) N = 1;
+    if (posix_memalign(&ptr, alignment, N * sizeof(double)) != 0) {
+        return NULL;
+    }
+    memset(ptr, 0, N * sizeof(double));
+    return (double*)ptr;
+}
+
+/******************************************************************************
+ * Kernels: C (M x N) = A (M x K) * B (K x N), row-major with leading
+ * dimensions lda/ldb/ldc in elements.
+ *****************************************************************************/
+static void matmul_naive(const double *A, const double *B, double *C,
+                         int M, int N, int K, int lda, int ldb, int ldc, int num_threads)
+{
+#pragma omp parallel for num_threads(num_threads)
+    for (int i = 0; i < M; i++) {
+        for (int j = 0; j < N; j++) {
+            double sum = 0.0;
+            for (int k = 0; k < K; k++) {
+                sum += A[(size_t)i*lda + k] * B[(size_t)k*ldb + j];
+            }
+            C[(size_t)i*ldc + j] = sum;
+        }
+    }
+}
+
+static void matmul_unrolled(const double *A, const double *B, double *C,
+                            int M, int N, int K, int lda, int ldb, int ldc, int num_threads)
+{
+#pragma omp parallel for num_threads(num_threads)
+    for (int i = 0; i < M; i++) {
+        const double *a = A + (size_t)i*lda;
+        for (int j = 0; j < N; j++) {
+            double sum = 0.0;
+            int k = 0;
+            /* Unroll the inner loop by 4 */
+            for (; k <= K - 4; k += 4) {
+                sum += a[k]   * B[(size_t)k*ldb + j]
+                     + a[k+1] * B[(size_t)(k+1)*ldb + j]
+                     + a[k+2] * B[(size_t)(k+2)*ldb + j]
+                     + a[k+3] * B[(size_t)(k+3)*ldb + j];
+            }
+            /* Handle leftover */
+            for (; k < K; k++) {
+                sum += a[k] * B[(size_t)k*ldb + j];
+            }
+            C[(size_t)i*ldc + j] = sum;
+        }
+    }
+}
+
+/* Same loop as matmul_naive; the caller guarantees 64-byte aligned rows. */
+static void matmul_aligned(const double *A, const double *B, double *C,
+                           int M, int N, int K, int lda, int ldb, int ldc, int num_threads)
+{
+    A = (const double*)__builtin_assume_aligned(A, MATMUL_ALIGNMENT);
+    B = (const double*)__builtin_assume_aligned(B, MATMUL_ALIGNMENT);
+    C = (double*)__builtin_assume_aligned(C, MATMUL_ALIGNMENT);
+    matmul_naive(A, B, C, M, N, K, lda, ldb, ldc, num_threads);
+}
+
+static void matmul_blocked(const double *A, const double *B, double *C,
+                           int M, int N, int K, int lda, int ldb, int ldc,
+                           int block_size, int num_threads)
+{
+#pragma omp parallel for num_threads(num_threads) collapse(2)
+    for (int iBlock = 0; iBlock < M; iBlock += block_size) {
+        for (int jBlock = 0; jBlock < N; jBlock += block_size) {
+            const int iEnd = iBlock + block_size < M ? iBlock + block_size : M;
+            const int jEnd = jBlock + block_size < N ? jBlock + block_size : N;
+
+            for (int i = iBlock; i < iEnd; i++) {
+                for (int j = jBlock; j < jEnd; j++) {
+                    C[(size_t)i*ldc + j] = 0.0;
+                }
+            }
+            for (int kBlock = 0; kBlock < K; kBlock += block_size) {
+                const int kEnd = kBlock + block_size < K ? kBlock + block_size : K;
+
+                for (int i = iBlock; i < iEnd; i++) {
+                    for (int j = jBlock; j < jEnd; j++) {
+                        double sum = C[(size_t)i*ldc + j];
+                        for (int k = kBlock; k < kEnd; k++) {
+                            sum += A[(size_t)i*lda + k] * B[(size_t)k*ldb + j];
+                        }
+                        C[(size_t)i*ldc + j] = sum;
+                    }
+                }
+            }
+        }
+    }
+}
+
+typedef enum { KERNEL_NAIVE, KERNEL_UNROLLED, KERNEL_BLOCKED, KERNEL_ALIGNED } kernel_id;
+
+static const struct {
+    const char *name;
+    kernel_id   id;
+    size_t      alignment;   /* required alignment of every row, in bytes */
+} KERNELS[] = {
+    { "naive",    KERNEL_NAIVE,    sizeof(double) },
+    { "unrolled", KERNEL_UNROLLED, sizeof(double) },
+    { "blocked",  KERNEL_BLOCKED,  sizeof(double) },
+    { "aligned",  KERNEL_ALIGNED,  MATMUL_ALIGNMENT },
+};
+
+/******************************************************************************
+ * matmul.Matrix: owned, 64-byte aligned, C-contiguous float64 matrix that
+ * exports itself through the buffer protocol.
+ *****************************************************************************/
+typedef struct {
+    PyObject_HEAD
+    double     *data;
+    Py_ssize_t  shape[2];
+    Py_ssize_t  strides[2];
+} MatrixObject;
+
+static PyTypeObject MatrixType;
+
+static MatrixObject* matrix_new_sized(Py_ssize_t rows, Py_ssize_t cols)
+{
+    MatrixObject *m = PyObject_New(MatrixObject, &MatrixType);
+    if (m == NULL) return NULL;
+
+    m->data = NULL;
+    m->data = aligned_alloc_doubles((size_t)rows * (size_t)cols, MATMUL_ALIGNMENT);
+    if (m->data == NULL) {
+        Py_DECREF(m);
+        PyErr_NoMemory();
+        return NULL;
+    }
+    m->shape[0]   = rows;
+    m->shape[1]   = cols;
+    m->strides[0] = cols * (Py_ssize_t)sizeof(double);
+    m->strides[1] = sizeof(double);
+    return m;
+}
+
+static PyObject* Matrix_new(PyTypeObject *type, PyObject *args, PyObject *kwds)
+{
+    static char *kwlist[] = { "rows", "cols", NULL };
+    Py_ssize_t rows, cols;
+
+    (void)type;
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "nn", kwlist, &rows, &cols)) return NULL;
+    if (rows < 0 || cols < 0 || rows > INT_MAX || cols > INT_MAX) {
+        PyErr_SetString(PyExc_ValueError, "Matrix dimensions must be in [0, INT_MAX]");
+        return NULL;
+    }
+    return (PyObject*)matrix_new_sized(rows, cols);
+}
+
+static void Matrix_dealloc(MatrixObject *self)
+{
+    free(self->data);
+    PyObject_Free(self);
+}
+
+static int Matrix_getbuffer(MatrixObject *self, Py_buffer *view, int flags)
+{
+    view->obj        = (PyObject*)self;
+    view->buf        = self->data;
+    view->len        = self->shape[0] * self->shape[1] * (Py_ssize_t)sizeof(double);
+    view->readonly   = 0;
+    view->itemsize   = sizeof(double);
+    view->format     = (flags & PyBUF_FORMAT) ? "d" : NULL;
+    view->ndim       = 2;
+    view->shape      = self->shape;
+    view->strides    = self->strides;
+    view->suboffsets = NULL;
+    view->internal   = NULL;
+    Py_INCREF(self);
+    return 0;
+}
+
+static PyObject* Matrix_get_shape(MatrixObject *self, void *closure)
+{
+    (void)closure;
+    return Py_BuildValue("(nn)", self->shape[0], self->shape[1]);
+}
+
+static PyObject* Matrix_tolist(MatrixObject *self, PyObject *unused)
+{
+    PyObject *rows = PyList_New(self->shape[0]);
+    (void)unused;
+    if (rows == NULL) return NULL;
+
+    for (Py_ssize_t i = 0; i < self->shape[0]; i++) {
+        PyObject *row = PyList_New(self->shape[1]);
+        if (row == NULL) {
+            Py_DECREF(rows);
+            return NULL;
+        }
+        for (Py_ssize_t j = 0; j < self->shape[1]; j++) {
+            PyObject *v = PyFloat_FromDouble(self->data[i*self->shape[1] + j]);
+            if (v == NULL) {
+                Py_DECREF(row);
+                Py_DECREF(rows);
+                return NULL;
+            }
+            PyList_SET_ITEM(row, j, v);
+        }
+        PyList_SET_ITEM(rows, i, row);
+    }
+    return rows;
+}
+
+static PyBufferProcs Matrix_as_buffer = {
+    (getbufferproc)Matrix_getbuffer,
+    NULL,
+};
+
+static PyGetSetDef Matrix_getset[] = {
+    { "shape", (getter)Matrix_get_shape, NULL, "(rows, cols)", NULL },
+    { NULL, NULL, NULL, NULL, NULL },
+};
+
+static PyMethodDef Matrix_methods[] = {
+    { "tolist", (PyCFunction)Matrix_tolist, METH_NOARGS, "Return the matrix as nested lists." },
+    { NULL, NULL, 0, NULL },
+};
+
+static PyTypeObject MatrixType = {
+    PyVarObject_HEAD_INIT(NULL, 0)
+    .tp_name      = "matmul.Matrix",
+    .tp_basicsize = sizeof(MatrixObject),
+    .tp_dealloc   = (destructor)Matrix_dealloc,
+    .tp_as_buffer = &Matrix_as_buffer,
+    .tp_flags     = Py_TPFLAGS_DEFAULT,
+    .tp_doc       = "Matrix(rows, cols): zeroed, 64-byte aligned float64 matrix "
+                    "(buffer protocol, use np.asarray() for a zero-copy view)",
+    .tp_methods   = Matrix_methods,
+    .tp_getset    = Matrix_getset,
+    .tp_new       = Matrix_new,
+};
+
+/******************************************************************************
+ * Operands: either a view of the caller's memory or an aligned private copy.
+ *****************************************************************************/
+typedef struct {
+    Py_buffer  view;
+    int        have_view;
+    double    *data;        /* what the kernel reads or writes */
+    double    *owned;       /* aligned copy, NULL when zero-copy */
+    int        rows, cols;
+    int        ld;          /* leading dimension of data, in elements */
+    char       kind;        /* 'd' (float64) or 'f' (float32) */
+    Py_ssize_t stride[2];   /* caller's strides in bytes */
+} operand;
+
+static unsigned long long zero_copy_count = 0;
+static unsigned long long copied_count    = 0;
+
+static char buffer_kind(const char *format)
+{
+    if (format == NULL) return 'B';
+    if (format[0] == '@' || format[0] == '=') format++;
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    else if (format[0] == '<') format++;
+#endif
+    if (strcmp(format, "d") == 0) return 'd';
+    if (strcmp(format, "f") == 0) return 'f';
+    return 0;
+}
+
+static void operand_release(operand *op)
+{
+    free(op->owned);
+    op->owned = NULL;
+    if (op->have_view) PyBuffer_Release(&op->view);
+    op->have_view = 0;
+}
+
+/* Byte range [lo, hi) touched by a view. Only meaningful for non-negative strides. */
+static void operand_extent(const operand *op, uintptr_t *lo, uintptr_t *hi)
+{
+    *lo = (uintptr_t)op->view.buf;
+    *hi = *lo;
+    if (op->rows > 0 && op->cols > 0) {
+        *hi += (uintptr_t)((op->rows - 1) * op->stride[0] + (op->cols - 1) * op->stride[1])
+             + op->view.itemsize;
+    }
+}
+
+static int operands_overlap(const operand *x, const operand *y)
+{
+    uintptr_t xlo, xhi, ylo, yhi;
+    operand_extent(x, &xlo, &xhi);
+    operand_extent(y, &ylo, &yhi);
+    return xlo < yhi && ylo < xhi;
+}
+
+/* Gets the buffer and checks it is a 2-D float64/float32 matrix. */
+static int operand_acquire(PyObject *obj, operand *op, const char *name, int writable)
+{
+    int flags = writable ? PyBUF_RECORDS : PyBUF_RECORDS_RO;
+
+    memset(op, 0, sizeof(*op));
+    if (PyObject_GetBuffer(obj, &op->view, flags) != 0) {
+        PyErr_Format(PyExc_TypeError, "%s must support the %sbuffer protocol",
+                     name, writable ? "writable " : "");
+        return -1;
+    }
+    op->have_view = 1;
+
+    op->kind = buffer_kind(op->view.format);
+    if (op->view.ndim != 2) {
+        PyErr_Format(PyExc_ValueError, "%s must be 2-D, got %d-D", name, op->view.ndim);
+        return -1;
+    }
+    if ((op->kind == 'd' && op->view.itemsize == 8) ||
+        (op->kind == 'f' && op->view.itemsize == 4 && !writable)) {
+        /* supported */
+    } else {
+        PyErr_Format(PyExc_TypeError, "%s must be float64%s (buffer format '%s')", name,
+                     writable ? "" : " or float32",
+                     op->view.format ? op->view.format : "B");
+        return -1;
+    }
+    if (op->view.shape[0] > INT_MAX || op->view.shape[1] > INT_MAX) {
+        PyErr_Format(PyExc_ValueError, "%s is too large", name);
+        return -1;
+    }
+    op->rows      = (int)op->view.shape[0];
+    op->cols      = (int)op->view.shape[1];
+    op->stride[0] = op->view.strides[0];
+    op->stride[1] = op->view.strides[1];
+    return 0;
+}
+
+/*
+ * True when the kernel can use the caller's memory directly: float64, unit
+ * stride along a row, whole-element non-negative row stride, and every row
+ * start aligned to `alignment`. Strides of length-1 dimensions are ignored.
+ */
+static int operand_conforms(const operand *op, size_t alignment)
+{
+    Py_ssize_t s0 = op->rows > 1 ? op->stride[0] : op->cols * (Py_ssize_t)sizeof(double);
+    Py_ssize_t s1 = op->cols > 1 ? op->stride[1] : (Py_ssize_t)sizeof(double);
+
+    if (op->kind != 'd' || s1 != (Py_ssize_t)sizeof(double)) return 0;
+    if (s0 < op->cols * (Py_ssize_t)sizeof(double) || s0 % (Py_ssize_t)sizeof(double) != 0) return 0;
+    if (s0 / (Py_ssize_t)sizeof(double) > INT_MAX) return 0;
+    if ((uintptr_t)op->view.buf % alignment != 0 || (size_t)s0 % alignment != 0) return 0;
+    return 1;
+}
+
+static inline int padded_ld(int cols)
+{
+    const int per_line = MATMUL_ALIGNMENT / sizeof(double);
+    return cols <= 0 ? per_line : (cols + per_line - 1) / per_line * per_line;
+}
+
+/* Describe a freshly allocated result matrix (no buffer view is held). */
+static void operand_from_matrix(operand *op, MatrixObject *m)
+{
+    op->view.buf      = m->data;
+    op->view.itemsize = sizeof(double);
+    op->rows          = (int)m->shape[0];
+    op->cols          = (int)m->shape[1];
+    op->stride[0]     = m->strides[0];
+    op->stride[1]     = m->strides[1];
+    op->kind          = 'd';
+}
+
+static int operand_use_in_place(operand *op)
+{
+    op->data = (double*)op->view.buf;
+    op->ld   = op->rows > 1 ? (int)(op->stride[0] / (Py_ssize_t)sizeof(double))
+                            : (op->cols > 0 ? op->cols : 1);
+    return 0;
+}
+
+static int operand_alloc_copy(operand *op)
+{
+    op->ld    = padded_ld(op->cols);
+    op->owned = aligned_alloc_doubles((size_t)op->rows * op->ld, MATMUL_ALIGNMENT);
+    if (op->owned == NULL) {
+        PyErr_NoMemory();
+        return -1;
+    }
+    op->data = op->owned;
+    return 0;
+}
+
+/* Gather an input into its aligned copy, converting float32 if needed. */
+static void operand_gather(operand *op)
+{
+    const char *base = (const char*)op->view.buf;
+
+    for (int i = 0; i < op->rows; i++) {
+        const char *row = base + i * op->stride[0];
+        double *dst     = op->owned + (size_t)i * op->ld;
+        if (op->kind == 'd') {
+            for (int j = 0; j < op->cols; j++) dst[j] = *(const double*)(row + j * op->stride[1]);
+        } else {
+            for (int j = 0; j < op->cols; j++) dst[j] = *(const float*)(row + j * op->stride[1]);
+        }
+    }
+}
+
+/* Scatter a private result back into the caller's `out`. */
+static void operand_scatter(const operand *op)
+{
+    char *base = (char*)op->view.buf;
+
+    for (int i = 0; i < op->rows; i++) {
+        char *row         = base + i * op->stride[0];
+        const double *src = op->owned + (size_t)i * op->ld;
+        for (int j = 0; j < op->cols; j++) *(double*)(row + j * op->stride[1]) = src[j];
+    }
+}
+
+static int prepare_input(operand *op, const operand *out, size_t alignment)
+{
+    int in_place = operand_conforms(op, alignment) &&
+                   (out == NULL || !operands_overlap(op, out));
+
+    if (in_place) {
+        zero_copy_count++;
+        return operand_use_in_place(op);
+    }
+    copied_count++;
+    if (operand_alloc_copy(op) != 0) return -1;
+    operand_gather(op);
+    return 0;
+}
+
+/******************************************************************************
+ * matmul.matmul(a, b, out=None, kernel="blocked", threads=0, block_size=64)
+ *****************************************************************************/
+PyDoc_STRVAR(matmul_doc,
+"matmul(a, b, out=None, kernel='blocked', threads=0, block_size=64)\n"
+"\n"
+"Return a @ b for 2-D float64 (or float32) buffers such as NumPy arrays.\n"
+"Conforming inputs are used without copying; the GIL is released while\n"
+"the kernel runs. kernel is one of 'naive', 'unrolled', 'blocked' and\n"
+"'aligned'; threads=0 uses omp_get_max_threads(). With out (a writable\n"
+"float64 buffer of shape (a.rows, b.cols)) the result is written there and\n"
+"out is returned, otherwise a new matmul.Matrix is returned.");
+
+static PyObject* py_matmul(PyObject *self, PyObject *args, PyObject *kwds)
+{
+    static char *kwlist[] = { "a", "b", "out", "kernel", "threads", "block_size", NULL };
+    PyObject *a_obj, *b_obj, *out_obj = Py_None, *result = NULL;
+    const char *kernel_name = "blocked";
+    int num_threads = 0, block_size = 64;
+    operand a, b, c;
+    size_t k_idx;
+
+    (void)self;
+    memset(&a, 0, sizeof(a));
+    memset(&b, 0, sizeof(b));
+    memset(&c, 0, sizeof(c));
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "OO|Osii", kwlist, &a_obj, &b_obj,
+                                     &out_obj, &kernel_name, &num_threads, &block_size)) {
+        return NULL;
+    }
+    for (k_idx = 0; k_idx < sizeof(KERNELS) / sizeof(KERNELS[0]); k_idx++) {
+        if (strcmp(KERNELS[k_idx].name, kernel_name) == 0) break;
+    }
+    if (k_idx == sizeof(KERNELS) / sizeof(KERNELS[0])) {
+        PyErr_Format(PyExc_ValueError, "unknown kernel '%s' "
+                     "(expected naive, unrolled, blocked or aligned)", kernel_name);
+        return NULL;
+    }
+    if (num_threads <= 0) num_threads = omp_get_max_threads();
+    if (block_size <= 0) {
+        PyErr_SetString(PyExc_ValueError, "block_size must be positive");
+        return NULL;
+    }
+
+    if (operand_acquire(a_obj, &a, "a", 0) != 0) goto done;
+    if (operand_acquire(b_obj, &b, "b", 0) != 0) goto done;
+    if (a.cols != b.rows) {
+        PyErr_Format(PyExc_ValueError, "shape mismatch: (%d, %d) @ (%d, %d)",
+                     a.rows, a.cols, b.rows, b.cols);
+        goto done;
+    }
+
+    const size_t alignment = KERNELS[k_idx].alignment;
+    const operand *out_range = NULL;
+
+    if (out_obj == Py_None) {
+        MatrixObject *m = matrix_new_sized(a.rows, b.cols);
+        if (m == NULL) goto done;
+        result = (PyObject*)m;
+        operand_from_matrix(&c, m);
+    } else {
+        if (operand_acquire(out_obj, &c, "out", 1) != 0) goto done;
+        if (c.rows != a.rows || c.cols != b.cols) {
+            PyErr_Format(PyExc_ValueError, "out has shape (%d, %d), expected (%d, %d)",
+                         c.rows, c.cols, a.rows, b.cols);
+            goto done;
+        }
+        out_range = &c;
+        Py_INCREF(out_obj);
+        result = out_obj;
+    }
+
+    if (operand_conforms(&c, alignment)) {
+        operand_use_in_place(&c);
+    } else if (operand_alloc_copy(&c) != 0) {
+        goto done;
+    }
+    if (prepare_input(&a, out_range, alignment) != 0) goto done;
+    if (prepare_input(&b, out_range, alignment) != 0) goto done;
+
+    Py_BEGIN_ALLOW_THREADS
+    switch (KERNELS[k_idx].id) {
+    case KERNEL_NAIVE:
+        matmul_naive(a.data, b.data, c.data, a.rows, b.cols, a.cols,
+                     a.ld, b.ld, c.ld, num_threads);
+        break;
+    case KERNEL_UNROLLED:
+        matmul_unrolled(a.data, b.data, c.data, a.rows, b.cols, a.cols,
+                        a.ld, b.ld, c.ld, num_threads);
+        break;
+    case KERNEL_ALIGNED:
+        matmul_aligned(a.data, b.data, c.data, a.rows, b.cols, a.cols,
+                       a.ld, b.ld, c.ld, num_threads);
+        break;
+    default:
+        matmul_blocked(a.data, b.data, c.data, a.rows, b.cols, a.cols,
+                       a.ld, b.ld, c.ld, block_size, num_threads);
+        break;
+    }
+    if (c.owned != NULL) operand_scatter(&c);
+    Py_END_ALLOW_THREADS
+
+done:
+    if (PyErr_Occurred()) Py_CLEAR(result);
+    operand_release(&a);
+    operand_release(&b);
+    operand_release(&c);
+    return result;
+}
+
+PyDoc_STRVAR(stats_doc,
+"stats(reset=False)\n"
+"\n"
+"Return {'zero_copy': n, 'copied': m}: how many input operands were used in\n"
+"place and how many had to be copied since the module was loaded (or since\n"
+"the last reset).");
+
+static PyObject* py_stats(PyObject *self, PyObject *args, PyObject *kwds)
+{
+    static char *kwlist[] = { "reset", NULL };
+    int reset = 0;
+    PyObject *d;
+
+    (void)self;
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "|p", kwlist, &reset)) return NULL;
+    d = Py_BuildValue("{s:K,s:K}", "zero_copy", zero_copy_count, "copied", copied_count);
+    if (reset) zero_copy_count = copied_count = 0;
+    return d;
+}
+
+static PyMethodDef matmul_methods[] = {
+    { "matmul", (PyCFunction)(void(*)(void))py_matmul, METH_VARARGS | METH_KEYWORDS, matmul_doc },
+    { "stats",  (PyCFunction)(void(*)(void))py_stats,  METH_VARARGS | METH_KEYWORDS, stats_doc },
+    { NULL, NULL, 0, NULL },
+};
+
+static struct PyModuleDef matmul_module = {
+    PyModuleDef_HEAD_INIT,
+    .m_name    = "matmul",
+    .m_doc     = "Zero-copy bindings for the OpenMP matrix multiplication kernels.",
+    .m_size    = -1,
+    .m_methods = matmul_methods,
+};
+
+PyMODINIT_FUNC PyInit_matmul(void)
+{
+    PyObject *m;
+
+    if (PyType_Ready(&MatrixType) < 0) return NULL;
+    m = PyModule_Create(&matmul_module);
+    if (m == NULL) return NULL;
+
+    Py_INCREF(&MatrixType);
+    if (PyModule_AddObject(m, "Matrix", (PyObject*)&MatrixType) < 0) {
+        Py_DECREF(&MatrixType);
+        Py_DECREF(m);
+        return NULL;
+    }
+    return m;
+}
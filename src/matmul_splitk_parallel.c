@@ -0,0 +1,391 @@
+/******************************************************************************
+ * File: matmul_splitk_parallel.c
+ *
+ * Description:
+ *   Split-K parallel multiplication for shapes with a small C and a long
+ *   inner dimension, C (M x N) = A (M x K) * B (K x N).
+ *
+ *   The tiled kernel (matmul_blocked's scheme) has only ceil(M/bs)*ceil(N/bs)
+ *   independent C tiles: a 256 x 256 x 1M product at block size 64 has 16,
+ *   and every thread beyond that sits idle. Split-K also partitions K
+ *   into S chunks. Work item (s, tile) computes the tile's partial product
+ *   over chunk s into a private copy of C (chunk 0 writes C itself). The S
+ *   partial results are then merged by a pairwise tree reduction, with each
+ *   level parallel over pairs and row bands:
+ *
+ *     level 1:  P0 += P1,  P2 += P3,  P4 += P5, ...
+ *     level 2:  P0 += P2,  P4 += P6, ...
+ *
+ *   Every element is summed in a fixed order: k ascending inside a chunk,
+ *   then the fixed tree. The result therefore depends only on S, not on
+ *   which thread did what. In deterministic mode S is derived from the
+ *   shape and block size alone (enough work items for 64 threads), so
+ *   results are bit-identical for any thread count. In the default mode S
+ *   follows the thread count.
+ *
+ *   matmul_auto() keeps the tiled kernel when there are at least as many C
+ *   tiles as threads, and switches to split-K when there are fewer.
+ *
+ * Compile:
+ *   gcc -fopenmp matmul_splitk_parallel.c -o matmul_splitk_parallel -O3 -lm
+ *
+ * Run:
+ *   ./matmul_splitk_parallel <M> <N> <K> <num_threads> <block_size>
+ *                            [auto|tiles|splitk|det|all]
+ *****************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <omp.h>
+#include <string.h>
+#include <time.h>
+#include <math.h>
+#include <float.h>
+
+#define DET_MAX_SPLITS       64
+#define DET_WORK_ITEMS       64             /* parallelism targeted by det mode */
+#define SPLIT_BUDGET_DOUBLES (32u << 20)    /* 256 MB of partial results */
+#define REDUCE_ROWS          16             /* rows per reduction work item */
+
+static inline double* aligned_alloc_doubles(size_t N, size_t alignment)
+{
+    void *ptr = NULL;
+    int ret = posix_memalign(&ptr, alignment, (N ? N : 1) * sizeof(double));
+    if (ret != 0) {
+        fprintf(stderr, "posix_memalign failed\n");
+        exit(EXIT_FAILURE);
+    }
+    memset(ptr, 0, N * sizeof(double));
+    return (double*)ptr;
+}
+
+static inline void fill_random_n(double *v, size_t n)
+{
+    for (size_t i = 0; i < n; i++) {
+        v[i] = (double)rand() / (double)RAND_MAX;
+    }
+}
+
+static inline double get_time_in_seconds()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1.0e-9;
+}
+
+static inline int min_int(int a, int b) { return a < b ? a : b; }
+static inline int ceil_div(long a, long b) { return (int)((a + b - 1) / b); }
+
+/******************************************************************************
+ * C tile (iBlock, jBlock) = A[iBlock.., k0:k1] * B[k0:k1, jBlock..]
+ * ikj inside the tile, k ascending for every element.
+ *****************************************************************************/
+static inline void tile_product(const double *A, const double *B, double *C,
+                                int M, int N, int K, int iBlock, int jBlock,
+                                int k0, int k1, int block_size)
+{
+    const int iEnd = min_int(iBlock + block_size, M);
+    const int jEnd = min_int(jBlock + block_size, N);
+
+    for (int i = iBlock; i < iEnd; i++) {
+        memset(C + (size_t)i*N + jBlock, 0, (size_t)(jEnd - jBlock) * sizeof(double));
+    }
+    for (int kBlock = k0; kBlock < k1; kBlock += block_size) {
+        const int kEnd = min_int(kBlock + block_size, k1);
+
+        for (int i = iBlock; i < iEnd; i++) {
+            double *c = C + (size_t)i*N;
+            for (int k = kBlock; k < kEnd; k++) {
+                const double  a = A[(size_t)i*K + k];
+                const double *b = B + (size_t)k*N;
+#pragma omp simd
+                for (int j = jBlock; j < jEnd; j++) {
+                    c[j] += a * b[j];
+                }
+            }
+        }
+    }
+}
+
+/******************************************************************************
+ * Tiled kernel: parallel over C tiles only (the matmul_blocked scheme).
+ *****************************************************************************/
+void matmul_tiles(const double *A, const double *B, double *C,
+                  int M, int N, int K, int block_size, int num_threads)
+{
+    const int tiles_n = ceil_div(N, block_size);
+    const int tiles   = ceil_div(M, block_size) * tiles_n;
+
+#pragma omp parallel for num_threads(num_threads) schedule(static)
+    for (int t = 0; t < tiles; t++) {
+        tile_product(A, B, C, M, N, K, (t / tiles_n) * block_size,
+                     (t % tiles_n) * block_size, 0, K, block_size);
+    }
+}
+
+/******************************************************************************
+ * Split-K with pairwise tree reduction
+ *****************************************************************************/
+
+/* Chunk boundaries: S near-equal ranges of K, rounded to whole k blocks. */
+static inline int split_begin(int s, int splits, int K, int block_size)
+{
+    const int kblocks = ceil_div(K, block_size);
+    return min_int((int)((long)kblocks * s / splits) * block_size, K);
+}
+
+/*
+ * Number of K chunks when splitting is deterministic. Depends only on the
+ * shape: enough (split, tile) work items for DET_WORK_ITEMS threads, so a C
+ * with that many tiles is not split at all.
+ */
+int splitk_deterministic_splits(int M, int N, int K, int block_size)
+{
+    size_t mn     = (size_t)M * N;
+    int    tiles  = ceil_div(M, block_size) * ceil_div(N, block_size);
+    int    splits = min_int(ceil_div(DET_WORK_ITEMS, tiles),
+                            min_int(DET_MAX_SPLITS, ceil_div(K, block_size)));
+
+    if (mn > 0 && (size_t)splits * mn > SPLIT_BUDGET_DOUBLES) {
+        splits = (int)(SPLIT_BUDGET_DOUBLES / mn);
+    }
+    return splits < 1 ? 1 : splits;
+}
+
+void matmul_splitk(const double *A, const double *B, double *C,
+                   int M, int N, int K, int block_size, int splits, int num_threads)
+{
+    const int    tiles_n = ceil_div(N, block_size);
+    const int    tiles   = ceil_div(M, block_size) * tiles_n;
+    const size_t mn      = (size_t)M * N;
+    double      *partial;
+
+    splits = min_int(splits, ceil_div(K, block_size));
+    if (splits <= 1 || mn == 0) {
+        matmul_tiles(A, B, C, M, N, K, block_size, num_threads);
+        return;
+    }
+
+    /* P_0 is C itself; P_1 .. P_{S-1} are private copies. */
+    partial = aligned_alloc_doubles((splits - 1) * mn, 64);
+
+#pragma omp parallel num_threads(num_threads)
+    {
+#pragma omp for collapse(2) schedule(static)
+        for (int s = 0; s < splits; s++) {
+            for (int t = 0; t < tiles; t++) {
+                double *P = (s == 0) ? C : partial + (size_t)(s - 1) * mn;
+                tile_product(A, B, P, M, N, K, (t / tiles_n) * block_size,
+                             (t % tiles_n) * block_size,
+                             split_begin(s, splits, K, block_size),
+                             split_begin(s + 1, splits, K, block_size), block_size);
+            }
+        }
+
+        /* Tree levels; the implicit barrier of each 'omp for' orders them. */
+        const int bands = ceil_div(M, REDUCE_ROWS);
+        for (int stride = 1; stride < splits; stride *= 2) {
+            const int pairs = ceil_div(splits, 2 * stride);
+
+#pragma omp for collapse(2) schedule(static)
+            for (int p = 0; p < pairs; p++) {
+                for (int band = 0; band < bands; band++) {
+                    const int dst = p * 2 * stride;
+                    const int src = dst + stride;
+                    if (src >= splits) continue;
+
+                    double       *d = (dst == 0) ? C : partial + (size_t)(dst - 1) * mn;
+                    const double *x = partial + (size_t)(src - 1) * mn;
+                    const size_t lo = (size_t)band * REDUCE_ROWS * N;
+                    const size_t hi = (size_t)min_int((band + 1) * REDUCE_ROWS, M) * N;
+#pragma omp simd
+                    for (size_t e = lo; e < hi; e++) {
+                        d[e] += x[e];
+                    }
+                }
+            }
+        }
+    }
+
+    free(partial);
+}
+
+/******************************************************************************
+ * Automatic selection
+ *****************************************************************************/
+typedef struct {
+    int use_splitk;
+    int splits;
+} splitk_plan;
+
+/*
+ * Split-K when C has fewer tiles than threads (and K is long enough to
+ * split); deterministic plans fix S independently of the thread count.
+ */
+splitk_plan matmul_plan(int M, int N, int K, int block_size, int num_threads,
+                        int deterministic)
+{
+    const int tiles   = ceil_div(M, block_size) * ceil_div(N, block_size);
+    const int kblocks = ceil_div(K, block_size);
+    splitk_plan plan  = { 0, 1 };
+
+    if (deterministic) {
+        plan.splits     = splitk_deterministic_splits(M, N, K, block_size);
+        plan.use_splitk = plan.splits > 1;
+        return plan;
+    }
+    if (tiles >= num_threads || kblocks < 2) return plan;
+
+    plan.splits = min_int(ceil_div(num_threads, tiles), kblocks);
+    if ((size_t)plan.splits * M * N > SPLIT_BUDGET_DOUBLES) {
+        plan.splits = (int)(SPLIT_BUDGET_DOUBLES / ((size_t)M * N));
+    }
+    plan.use_splitk = plan.splits > 1;
+    return plan;
+}
+
+splitk_plan matmul_auto(const double *A, const double *B, double *C,
+                        int M, int N, int K, int block_size, int num_threads,
+                        int deterministic)
+{
+    splitk_plan plan = matmul_plan(M, N, K, block_size, num_threads, deterministic);
+
+    if (plan.use_splitk) {
+        matmul_splitk(A, B, C, M, N, K, block_size, plan.splits, num_threads);
+    } else {
+        matmul_tiles(A, B, C, M, N, K, block_size, num_threads);
+    }
+    return plan;
+}
+
+/******************************************************************************
+ * Benchmark driver
+ *****************************************************************************/
+static double max_rel_diff(const double *X, const double *Y, size_t n)
+{
+    double max_diff = 0.0, max_ref = 0.0;
+    for (size_t i = 0; i < n; i++) {
+        double d = fabs(X[i] - Y[i]);
+        if (d > max_diff) max_diff = d;
+        if (fabs(Y[i]) > max_ref) max_ref = fabs(Y[i]);
+    }
+    return max_ref > 0.0 ? max_diff / max_ref : max_diff;
+}
+
+static void report(const char *mode, int M, int N, int K, int num_threads, int block_size,
+                   const char *kernel, int splits, double seconds, double rel_diff)
+{
+    printf("[SplitK] M=%d, N=%d, K=%d, threads=%d, block_size=%d, mode=%s, "
+           "kernel=%s, splits=%d, time=%f sec, GFLOP/s=%.3f, max_rel_diff=%e\n",
+           M, N, K, num_threads, block_size, mode, kernel, splits, seconds,
+           2.0 * M * N * (double)K / seconds * 1.0e-9, rel_diff);
+}
+
+int main(int argc, char* argv[])
+{
+    if (argc < 6) {
+        fprintf(stderr, "Usage: %s <M> <N> <K> <num_threads> <block_size> "
+                        "[auto|tiles|splitk|det|all]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    int M           = atoi(argv[1]);
+    int N           = atoi(argv[2]);
+    int K           = atoi(argv[3]);
+    int num_threads = atoi(argv[4]);
+    int block_size  = atoi(argv[5]);
+    const char *mode = (argc > 6) ? argv[6] : "all";
+    int run_tiles  = !strcmp(mode, "tiles")  || !strcmp(mode, "all");
+    int run_auto   = !strcmp(mode, "auto")   || !strcmp(mode, "all");
+    int run_splitk = !strcmp(mode, "splitk") || !strcmp(mode, "all");
+    int run_det    = !strcmp(mode, "det")    || !strcmp(mode, "all");
+
+    if (!run_tiles && !run_auto && !run_splitk && !run_det) {
+        fprintf(stderr, "Unknown mode '%s'\n", mode);
+        return EXIT_FAILURE;
+    }
+    if (M <= 0 || N <= 0 || K <= 0 || num_threads <= 0 || block_size <= 0) {
+        fprintf(stderr, "All sizes, num_threads and block_size must be positive\n");
+        return EXIT_FAILURE;
+    }
+
+    const size_t mn = (size_t)M * N;
+    double *A    = aligned_alloc_doubles((size_t)M * K, 64);
+    double *B    = aligned_alloc_doubles((size_t)K * N, 64);
+    double *C    = aligned_alloc_doubles(mn, 64);
+    double *Cref = aligned_alloc_doubles(mn, 64);
+    /* Inputs are in [0, 1], so K*eps bounds the relative error of any order. */
+    double tol   = K * DBL_EPSILON;
+    int failures = 0;
+
+    srand((unsigned)time(NULL));
+
+    fill_random_n(A, (size_t)M * K);
+    fill_random_n(B, (size_t)K * N);
+
+    /* Reference: tiled kernel (also the "tiles" timing). */
+    double start = get_time_in_seconds();
+    matmul_tiles(A, B, Cref, M, N, K, block_size, num_threads);
+    double tiles_time = get_time_in_seconds() - start;
+    if (run_tiles) {
+        report("tiles", M, N, K, num_threads, block_size, "tiles", 1, tiles_time, 0.0);
+    }
+
+    if (run_auto) {
+        start = get_time_in_seconds();
+        splitk_plan plan = matmul_auto(A, B, C, M, N, K, block_size, num_threads, 0);
+        double t = get_time_in_seconds() - start;
+        double rel_diff = max_rel_diff(C, Cref, mn);
+        report("auto", M, N, K, num_threads, block_size,
+               plan.use_splitk ? "splitk" : "tiles", plan.splits, t, rel_diff);
+        failures += rel_diff > tol;
+    }
+
+    if (run_splitk) {
+        int splits = min_int(num_threads, ceil_div(K, block_size));
+        start = get_time_in_seconds();
+        matmul_splitk(A, B, C, M, N, K, block_size, splits, num_threads);
+        double t = get_time_in_seconds() - start;
+        double rel_diff = max_rel_diff(C, Cref, mn);
+        report("splitk", M, N, K, num_threads, block_size, "splitk", splits, t, rel_diff);
+        failures += rel_diff > tol;
+    }
+
+    if (run_det) {
+        /* Same plan for every thread count: compare bitwise against 1 thread. */
+        double *C1 = aligned_alloc_doubles(mn, 64);
+        int identical = 1;
+
+        matmul_auto(A, B, C1, M, N, K, block_size, 1, 1);
+        for (int t = 2; t <= num_threads; t *= 2) {
+            matmul_auto(A, B, C, M, N, K, block_size, t, 1);
+            identical = identical && memcmp(C, C1, mn * sizeof(double)) == 0;
+        }
+
+        start = get_time_in_seconds();
+        splitk_plan plan = matmul_auto(A, B, C, M, N, K, block_size, num_threads, 1);
+        double t = get_time_in_seconds() - start;
+        identical = identical && memcmp(C, C1, mn * sizeof(double)) == 0;
+
+        double rel_diff = max_rel_diff(C, Cref, mn);
+        report("det", M, N, K, num_threads, block_size,
+               plan.use_splitk ? "splitk" : "tiles", plan.splits, t, rel_diff);
+        printf("[SplitK] deterministic results across 1..%d threads: %s\n",
+               num_threads, identical ? "bit-identical" : "DIFFERENT");
+        free(C1);
+        failures += rel_diff > tol;
+        failures += !identical;
+    }
+
+    free(A);
+    free(B);
+    free(C);
+    free(Cref);
+
+    if (failures > 0) {
+        fprintf(stderr, "Split-K results differ from the tiled reference beyond K*eps "
+                        "or across thread counts\n");
+        return EXIT_FAILURE;
+    }
+    return 0;
+}
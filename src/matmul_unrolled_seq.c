@@ -3,6 +3,7 @@
 #include <string.h>
 #include <time.h>
 #include <assert.h>
+#include "rapl_energy.h"
 
 /* Utility: Aligned allocation */
 static inline double* aligned_alloc_doubles(size_t N, size_t alignment)
@@ -78,11 +79,17 @@ int main(int argc, char* argv[])
     fill_random(A, N);
     fill_random(B, N);
 
+    rapl_meter energy;
+    rapl_start(&energy);
+
     double start = get_time_in_seconds();
     matmul_unrolled(A, B, C, N);
     double end   = get_time_in_seconds();
+    double joules = rapl_stop(&energy);
 
-    printf("[Unrolled] N=%d, time=%f sec\n", N, end - start);
+    printf("[Unrolled] N=%d, time=%f sec", N, end - start);
+    rapl_print_fields(joules, end - start, 2.0 * N * N * N);
+    printf("\n");
 
     free(A);
     free(B);
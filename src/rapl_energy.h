@@ -0,0 +1,157 @@
+/******************************************************************************
+ * File: rapl_energy.h
+ *
+ * Description:
+ *   Optional energy measurement through the Linux powercap/RAPL sysfs
+ *   interface (/sys/class/powercap/intel-rapl:*). Sums every package zone
+ *   and its DRAM subzone (psys and core/uncore zones are skipped so nothing
+ *   is counted twice), handling counter wraparound.
+ *
+ *   Measurement is off unless MATMUL_ENERGY is set in the environment. If
+ *   the counters are missing or not readable (energy_uj is root-only on
+ *   most distributions), a single note goes to stderr and the program
+ *   output is unchanged. When it works, the drivers append
+ *     , joules=..., watts=..., gflops_per_watt=...
+ *   to their usual "[Name] N=..., time=... sec" line, which
+ *   scripts/draw_graph.py picks up.
+ *
+ * Usage:
+ *   rapl_meter m;
+ *   rapl_start(&m);
+ *   ... timed region ...
+ *   double joules = rapl_stop(&m);
+ *   printf("[Name] ..., time=%f sec", seconds);
+ *   rapl_print_fields(joules, seconds, flops);
+ *   printf("\n");
+ *****************************************************************************/
+
+#ifndef RAPL_ENERGY_H
+#define RAPL_ENERGY_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <dirent.h>
+
+#ifndef RAPL_ROOT
+#define RAPL_ROOT        "/sys/class/powercap"
+#endif
+#define RAPL_MAX_ZONES   16
+#define RAPL_PATH_LEN    320
+
+typedef struct {
+    int                n;
+    char               path[RAPL_MAX_ZONES][RAPL_PATH_LEN];
+    unsigned long long range[RAPL_MAX_ZONES];
+    unsigned long long start[RAPL_MAX_ZONES];
+} rapl_meter;
+
+static inline int rapl_read_ull(const char *path, unsigned long long *value)
+{
+    FILE *f = fopen(path, "r");
+    int ok;
+    if (f == NULL) return 0;
+    ok = fscanf(f, "%llu", value) == 1;
+    fclose(f);
+    return ok;
+}
+
+static inline int rapl_read_name(const char *zone, char *name, size_t len)
+{
+    char path[RAPL_PATH_LEN];
+    FILE *f;
+
+    snprintf(path, sizeof(path), "%s/%s/name", RAPL_ROOT, zone);
+    f = fopen(path, "r");
+    if (f == NULL) return 0;
+    if (fgets(name, (int)len, f) == NULL) name[0] = '\0';
+    name[strcspn(name, "\n")] = '\0';
+    fclose(f);
+    return 1;
+}
+
+/*
+ * Top-level zones "intel-rapl:N" are wanted only when named "package-*":
+ * psys (platform) already includes the packages and would double-count.
+ * Of a package's subzones only DRAM is disjoint from the package total.
+ */
+static inline int rapl_zone_wanted(const char *zone)
+{
+    char name[64], parent[64];
+    const char *p, *second = NULL;
+    int colons = 0;
+
+    if (strncmp(zone, "intel-rapl:", 11) != 0) return 0;
+    for (p = zone; *p; p++) {
+        if (*p == ':' && ++colons == 2) second = p;
+    }
+    if (colons == 1) {
+        return rapl_read_name(zone, name, sizeof(name)) &&
+               strncmp(name, "package-", 8) == 0;
+    }
+    if (colons != 2 || (size_t)(second - zone) >= sizeof(parent)) return 0;
+
+    memcpy(parent, zone, (size_t)(second - zone));
+    parent[second - zone] = '\0';
+    return rapl_zone_wanted(parent) &&
+           rapl_read_name(zone, name, sizeof(name)) && strcmp(name, "dram") == 0;
+}
+
+/* Returns the number of zones being measured; 0 when disabled or unavailable. */
+static inline int rapl_start(rapl_meter *m)
+{
+    static int warned = 0;
+    DIR *dir;
+    struct dirent *ent;
+
+    m->n = 0;
+    if (getenv("MATMUL_ENERGY") == NULL) return 0;
+
+    dir = opendir(RAPL_ROOT);
+    while (dir != NULL && (ent = readdir(dir)) != NULL && m->n < RAPL_MAX_ZONES) {
+        char range_path[RAPL_PATH_LEN];
+        int z = m->n;
+
+        if (!rapl_zone_wanted(ent->d_name)) continue;
+        snprintf(m->path[z], RAPL_PATH_LEN, "%s/%s/energy_uj", RAPL_ROOT, ent->d_name);
+        snprintf(range_path, sizeof(range_path), "%s/%s/max_energy_range_uj",
+                 RAPL_ROOT, ent->d_name);
+        if (!rapl_read_ull(range_path, &m->range[z])) m->range[z] = 0;
+        if (rapl_read_ull(m->path[z], &m->start[z])) m->n++;
+    }
+    if (dir != NULL) closedir(dir);
+
+    if (m->n == 0 && !warned) {
+        fprintf(stderr, "Note: MATMUL_ENERGY is set but no readable RAPL counters "
+                        "under %s; energy is not reported.\n", RAPL_ROOT);
+        warned = 1;
+    }
+    return m->n;
+}
+
+/* Joules consumed since rapl_start(), or a negative value if unavailable. */
+static inline double rapl_stop(const rapl_meter *m)
+{
+    unsigned long long total_uj = 0;
+
+    if (m->n == 0) return -1.0;
+    for (int z = 0; z < m->n; z++) {
+        unsigned long long now;
+        if (!rapl_read_ull(m->path[z], &now)) return -1.0;
+        if (now >= m->start[z]) total_uj += now - m->start[z];
+        else                    total_uj += m->range[z] - m->start[z] + now;
+    }
+    return (double)total_uj * 1.0e-6;
+}
+
+/* Appends ", joules=..., watts=..., gflops_per_watt=..." when joules >= 0. */
+static inline void rapl_print_fields(double joules, double seconds, double flops)
+{
+    if (joules < 0.0 || seconds <= 0.0) return;
+
+    double watts = joules / seconds;
+    printf(", joules=%f, watts=%f, gflops_per_watt=%f",
+           joules, watts, watts > 0.0 ? flops / seconds * 1.0e-9 / watts : 0.0);
+}
+
+#endif /* RAPL_ENERGY_H */
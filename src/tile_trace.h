@@ -0,0 +1,205 @@
+/******************************************************************************
+ * File: tile_trace.h
+ *
+ * Description:
+ *   Lightweight per-thread timeline tracing for the parallel kernels, as a
+ *   VTune-free way to see load imbalance, barrier waits and stragglers.
+ *
+ *   Each OpenMP thread writes begin/end timestamps of the tiles or rows it
+ *   computes into its own preallocated ring buffer (oldest events are
+ *   overwritten when it fills up), so the hot path takes no locks and does
+ *   no allocation. After the run the buffers are exported as Chrome trace
+ *   JSON, which opens in chrome://tracing or https://ui.perfetto.dev.
+ *
+ *   Tracing is off unless MATMUL_TRACE=<output.json> is set; when off each
+ *   hook is a single predictable branch. MATMUL_TRACE_EVENTS sets the ring
+ *   capacity per thread (default 65536 events).
+ *
+ * Usage (inside an omp parallel region):
+ *   double t = trace_begin(&trace);
+ *   ... compute tile ...
+ *   trace_record(&trace, tid, TRACE_TILE, t, iBlock, jBlock);
+ *   ...
+ *   trace_barrier(&trace, tid);   // after an 'omp for nowait'
+ *****************************************************************************/
+
+#ifndef TILE_TRACE_H
+#define TILE_TRACE_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <omp.h>
+
+#define TRACE_DEFAULT_EVENTS  65536u
+
+typedef enum { TRACE_TILE, TRACE_ROWS, TRACE_BARRIER } trace_kind;
+
+typedef struct {
+    double     begin, end;     /* microseconds since trace_init() */
+    int        a, b;           /* tile (iBlock, jBlock) or rows [a, b) */
+    trace_kind kind;
+} trace_event;
+
+/* One ring per thread, padded so neighbouring counters never share a line. */
+typedef struct {
+    trace_event        *events;
+    unsigned long long  count;
+    char                pad[64 - sizeof(trace_event*) - sizeof(unsigned long long)];
+} trace_ring;
+
+typedef struct {
+    int         enabled;
+    int         num_threads;
+    unsigned    capacity;
+    double      t0;
+    const char *path;
+    trace_ring *rings;
+} tile_trace;
+
+static inline double trace_clock_us(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1.0e6 + (double)ts.tv_nsec * 1.0e-3;
+}
+
+/* Returns 1 if tracing is enabled (MATMUL_TRACE set and buffers allocated). */
+static inline int trace_init(tile_trace *t, int num_threads)
+{
+    const char *cap = getenv("MATMUL_TRACE_EVENTS");
+
+    memset(t, 0, sizeof(*t));
+    t->path = getenv("MATMUL_TRACE");
+    if (t->path == NULL || t->path[0] == '\0' || num_threads < 1) return 0;
+
+    t->capacity = (cap != NULL && atoi(cap) > 0) ? (unsigned)atoi(cap) : TRACE_DEFAULT_EVENTS;
+    t->num_threads = num_threads;
+    if (posix_memalign((void**)&t->rings, 64, (size_t)num_threads * sizeof(trace_ring)) != 0) {
+        return 0;
+    }
+    memset(t->rings, 0, (size_t)num_threads * sizeof(trace_ring));
+
+    for (int i = 0; i < num_threads; i++) {
+        t->rings[i].events = (trace_event*)calloc(t->capacity, sizeof(trace_event));
+        if (t->rings[i].events == NULL) {
+            fprintf(stderr, "Note: not enough memory for trace buffers; tracing disabled.\n");
+            for (int j = 0; j < i; j++) free(t->rings[j].events);
+            free(t->rings);
+            t->rings = NULL;
+            return 0;
+        }
+    }
+    t->t0 = trace_clock_us();
+    t->enabled = 1;
+    return 1;
+}
+
+static inline double trace_begin(const tile_trace *t)
+{
+    return t->enabled ? trace_clock_us() - t->t0 : 0.0;
+}
+
+static inline void trace_record(tile_trace *t, int tid, trace_kind kind,
+                                double begin, int a, int b)
+{
+    if (!t->enabled || tid >= t->num_threads) return;
+
+    trace_ring *r  = &t->rings[tid];
+    trace_event *e = &r->events[r->count % t->capacity];
+    e->begin = begin;
+    e->end   = trace_clock_us() - t->t0;
+    e->a     = a;
+    e->b     = b;
+    e->kind  = kind;
+    r->count++;
+}
+
+/*
+ * Timed barrier for the end of an 'omp for nowait' loop: records how long
+ * each thread waited for the slowest one. Must be reached by all threads of
+ * the team; without tracing the region's implicit barrier does the job.
+ */
+static inline void trace_barrier(tile_trace *t, int tid)
+{
+    if (!t->enabled) return;
+
+    double begin = trace_begin(t);
+#pragma omp barrier
+    trace_record(t, tid, TRACE_BARRIER, begin, 0, 0);
+}
+
+/* Writes Chrome trace JSON; returns the number of events written or -1. */
+static inline long trace_write_chrome(const tile_trace *t, const char *kernel_name)
+{
+    FILE *f;
+    long written = 0;
+    unsigned long long dropped = 0;
+
+    if (!t->enabled) return 0;
+    f = fopen(t->path, "w");
+    if (f == NULL) {
+        fprintf(stderr, "Cannot write trace file '%s'\n", t->path);
+        return -1;
+    }
+
+    fprintf(f, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    fprintf(f, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"tid\":0,"
+               "\"args\":{\"name\":\"%s\"}}", kernel_name);
+
+    for (int tid = 0; tid < t->num_threads; tid++) {
+        const trace_ring *r = &t->rings[tid];
+        unsigned long long first = r->count > t->capacity ? r->count - t->capacity : 0;
+
+        dropped += first;
+        fprintf(f, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,"
+                   "\"args\":{\"name\":\"omp thread %d\"}}", tid, tid);
+
+        for (unsigned long long n = first; n < r->count; n++) {
+            const trace_event *e = &r->events[n % t->capacity];
+            double dur = e->end - e->begin;
+
+            switch (e->kind) {
+            case TRACE_TILE:
+                fprintf(f, ",\n{\"name\":\"tile\",\"cat\":\"compute\",\"ph\":\"X\","
+                           "\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":%d,"
+                           "\"args\":{\"i\":%d,\"j\":%d}}",
+                        e->begin, dur, tid, e->a, e->b);
+                break;
+            case TRACE_ROWS:
+                fprintf(f, ",\n{\"name\":\"rows\",\"cat\":\"compute\",\"ph\":\"X\","
+                           "\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":%d,"
+                           "\"args\":{\"first\":%d,\"last\":%d}}",
+                        e->begin, dur, tid, e->a, e->b - 1);
+                break;
+            default:
+                fprintf(f, ",\n{\"name\":\"barrier\",\"cat\":\"wait\",\"ph\":\"X\","
+                           "\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":%d}",
+                        e->begin, dur, tid);
+                break;
+            }
+            written++;
+        }
+    }
+    fprintf(f, "\n]}\n");
+    fclose(f);
+
+    fprintf(stderr, "Trace: %ld events written to %s", written, t->path);
+    if (dropped > 0) {
+        fprintf(stderr, " (%llu oldest dropped; raise MATMUL_TRACE_EVENTS)", dropped);
+    }
+    fprintf(stderr, "\n");
+    return written;
+}
+
+static inline void trace_free(tile_trace *t)
+{
+    if (t->rings != NULL) {
+        for (int i = 0; i < t->num_threads; i++) free(t->rings[i].events);
+        free(t->rings);
+    }
+    memset(t, 0, sizeof(*t));
+}
+
+#endif /* TILE_TRACE_H */